@@ -48,7 +48,207 @@ static net role;
 static int role_hit, role_miss;
 static double role_avg;
 
-static int eval_cache_hit, eval_cache_miss;
+/*
+ * Counters for evaluation cache usefulness.
+ */
+long ai_cache_hit, ai_cache_miss;
+
+/*
+ * Wall time allowed for each AI decision in seconds (zero for no
+ * limit).
+ */
+double ai_time_budget;
+
+/*
+ * Number of network configurations kept loaded at once (zero for no
+ * limit).
+ */
+int ai_max_networks;
+
+/*
+ * Time at which the current decision should stop searching (zero if
+ * there is no limit).
+ */
+static double ai_deadline;
+
+/*
+ * Current decision has run out of time.
+ */
+static int ai_timed_out;
+
+/*
+ * Number of decisions cut short by the time budget.
+ */
+long ai_num_timeout;
+
+/*
+ * Function polled during searches; a nonzero return abandons the
+ * current decision (NULL to never abandon).
+ */
+int (*ai_interrupt)(void);
+
+/*
+ * Current decision was abandoned by ai_interrupt().
+ */
+int ai_interrupted;
+
+/*
+ * Profiling counters for one kind of decision.
+ */
+typedef struct ai_prof
+{
+	/* Number of decisions made */
+	long count;
+
+	/* Wall time spent in seconds */
+	double time;
+
+	/* Number of simulated game copies */
+	long sims;
+
+	/* Number of game evaluations and evaluation cache hits */
+	long evals;
+	long hits;
+
+	/* Number of network computations */
+	long computes;
+
+} ai_prof;
+
+/*
+ * Profiling counters for each choice type, with explore sampling last.
+ *
+ * Only decisions in real (non-simulated) games are counted.  The AI
+ * keeps its state in static variables, so it only ever runs on one
+ * thread of a process and the counters need no locking.
+ */
+static ai_prof ai_profile[MAX_CHOICE + 1];
+
+/*
+ * Totals used to compute profile deltas.
+ */
+static long num_sims, num_evals;
+
+/*
+ * Return the current wall clock time in seconds.
+ */
+static double profile_time(void)
+{
+	struct timespec ts;
+
+	/* Get monotonic time */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	/* Convert to seconds */
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Remember current counter totals at the start of a decision.
+ */
+static void profile_start(ai_prof *mark)
+{
+	/* Save totals */
+	mark->count = 1;
+	mark->time = profile_time();
+	mark->sims = num_sims;
+	mark->evals = num_evals;
+	mark->hits = ai_cache_hit;
+	mark->computes = net_num_computes;
+}
+
+/*
+ * Add the work done since the start of a decision to its profile.
+ */
+static void profile_stop(int kind, ai_prof *mark)
+{
+	ai_prof *p_ptr = &ai_profile[kind];
+
+	/* Add differences from saved totals */
+	p_ptr->count += mark->count;
+	p_ptr->time += profile_time() - mark->time;
+	p_ptr->sims += num_sims - mark->sims;
+	p_ptr->evals += num_evals - mark->evals;
+	p_ptr->hits += ai_cache_hit - mark->hits;
+	p_ptr->computes += net_num_computes - mark->computes;
+}
+
+/*
+ * Print the profile of each kind of decision made so far.
+ */
+void ai_print_profile(FILE *fff)
+{
+	ai_prof *p_ptr;
+	int i;
+
+	/* Print header */
+	fprintf(fff, "%-17s %8s %10s %10s %10s %10s %10s\n", "choice",
+	        "count", "seconds", "sims", "evals", "hits", "computes");
+
+	/* Loop over decision kinds */
+	for (i = 0; i <= MAX_CHOICE; i++)
+	{
+		/* Get profile */
+		p_ptr = &ai_profile[i];
+
+		/* Skip kinds never asked */
+		if (!p_ptr->count) continue;
+
+		/* Print counters */
+		fprintf(fff, "%-17s %8ld %10.3f %10ld %10ld %10ld %10ld\n",
+		        i < MAX_CHOICE ? choice_name[i] : "explore",
+		        p_ptr->count, p_ptr->time, p_ptr->sims, p_ptr->evals,
+		        p_ptr->hits, p_ptr->computes);
+	}
+
+	/* Send output now */
+	fflush(fff);
+}
+
+/*
+ * Check whether the current decision should be abandoned.
+ */
+static int ai_check_interrupt(void)
+{
+	/* Check for decision already abandoned */
+	if (ai_interrupted) return 1;
+
+	/* Check for no interrupt function or no reason to stop */
+	if (!ai_interrupt || !ai_interrupt()) return 0;
+
+	/* Abandon rest of decision */
+	ai_interrupted = 1;
+
+	/* Stop */
+	return 1;
+}
+
+/*
+ * Check whether the current decision has run out of time.
+ *
+ * Exhaustive searches call this before trying each candidate once a
+ * best-so-far answer exists, and return that answer when time is up.
+ */
+static int ai_out_of_time(void)
+{
+	/* Check for time already up */
+	if (ai_timed_out) return 1;
+
+	/* Check for abandoned decision */
+	if (ai_check_interrupt()) return 1;
+
+	/* Check for no limit or time remaining */
+	if (!ai_deadline || profile_time() < ai_deadline) return 0;
+
+	/* Time is up for the rest of this decision */
+	ai_timed_out = 1;
+
+	/* Count decision cut short */
+	ai_num_timeout++;
+
+	/* Out of time */
+	return 1;
+}
 
 /*
  * Size of evaluator neural net.
@@ -92,6 +292,8 @@ static int eval_cache_hit, eval_cache_miss;
 static void initial_training(game *g);
 static void setup_nets(game *g);
 static void fill_adv_combo(void);
+static void clear_eval_cache(void);
+static void use_nets(game *g, double factor);
 
 
 /*
@@ -99,86 +301,11 @@ static void fill_adv_combo(void);
  */
 static void ai_initialize(game *g, int who, double factor)
 {
-	char fname[1024], msg[1024];
-	static int loaded_p, loaded_e, loaded_a;
-
 	/* Create table of advanced action combinations */
 	fill_adv_combo();
 
-	/* Do nothing if correct networks already loaded */
-	if (loaded_p == g->num_players && loaded_e == g->expanded &&
-	    loaded_a == g->advanced) return;
-
-	/* Free old networks if some already loaded */
-	if (loaded_p > 0)
-	{
-		/* Free old networks */
-		free_net(&eval);
-		free_net(&role);
-	}
-
-	/* Compute size and input names of networks */
-	setup_nets(g);
-
-	/* Set learning rate */
-	eval.alpha = 0.0001 * factor;
-#ifdef DEBUG
-	eval.alpha = 0.0;
-#endif
-
-	/* Create evaluator filename */
-	sprintf(fname, RFTGDIR "/network/rftg.eval.%d.%d%s.net", g->expanded,
-	        g->num_players, g->advanced ? "a" : "");
-
-	/* Attempt to load network weights from disk */
-	if (load_net(&eval, fname))
-	{
-		/* Try looking under current directory */
-		sprintf(fname, "network/rftg.eval.%d.%d%s.net", g->expanded,
-		        g->num_players, g->advanced ? "a" : "");
-
-		/* Attempt to load again */
-		if (load_net(&eval, fname))
-		{
-			/* Print warning */
-			sprintf(msg, "Warning: Couldn't open %s\n", fname);
-			display_error(msg);
-
-			/* Perform initial training on new network */
-			initial_training(g);
-		}
-	}
-
-	/* Set learning rate */
-	role.alpha = 0.0005 * factor;
-#ifdef DEBUG
-	role.alpha = 0.0;
-#endif
-
-	/* Create predictor filename */
-	sprintf(fname, RFTGDIR "/network/rftg.role.%d.%d%s.net", g->expanded,
-	        g->num_players, g->advanced ? "a" : "");
-
-	/* Attempt to load network weights from disk */
-	if (load_net(&role, fname))
-	{
-		/* Try looking under current directory */
-		sprintf(fname, "network/rftg.role.%d.%d%s.net", g->expanded,
-		        g->num_players, g->advanced ? "a" : "");
-
-		/* Attempt to load again */
-		if (load_net(&role, fname))
-		{
-			/* Print warning */
-			sprintf(msg, "Warning: Couldn't open %s\n", fname);
-			display_error(msg);
-		}
-	}
-
-	/* Mark network as loaded */
-	loaded_p = g->num_players;
-	loaded_e = g->expanded;
-	loaded_a = g->advanced;
+	/* Use (and load if needed) networks for this game */
+	use_nets(g, factor);
 }
 
 /*
@@ -197,8 +324,11 @@ static void simulate_game(game *sim, game *orig, int who)
 {
 	int i;
 
+	/* Count simulation */
+	num_sims++;
+
 	/* Copy game */
-	memcpy(sim, orig, sizeof(game));
+	copy_game(sim, orig);
 
 	/* Loop over players */
 	for (i = 0; i < sim->num_players; i++)
@@ -1020,6 +1150,50 @@ static int role_out[ROLE_OUT_EXP3] =
 static int card_input[MAX_DESIGN], num_c_input;
 static int good_input[MAX_DESIGN], num_g_input;
 
+/*
+ * Networks and input mappings for one game configuration.
+ *
+ * The configuration in use lives in the "eval" and "role" networks and
+ * the input mappings above, and is copied back here when another
+ * configuration is used.
+ */
+typedef struct net_config
+{
+	/* Game configuration (zero players if slot is unused) */
+	int expanded, num_players, advanced;
+
+	/* Networks (weights, training state and scratch space) */
+	net eval, role;
+
+	/* Mapping from card indices to inputs */
+	int card_input[MAX_DESIGN], num_c_input;
+	int good_input[MAX_DESIGN], num_g_input;
+
+	/* Time of last use */
+	unsigned long last_used;
+
+} net_config;
+
+/*
+ * Most configurations there can be.
+ */
+#define MAX_NET_CONFIG (MAX_EXPANSION * MAX_PLAYER * 2)
+
+/*
+ * Loaded network configurations.
+ */
+static net_config net_configs[MAX_NET_CONFIG];
+
+/*
+ * Configuration currently in use (NULL for none).
+ */
+static net_config *active_config;
+
+/*
+ * Counter used to find least recently used configuration.
+ */
+static unsigned long config_clock;
+
 /*
  * Setup mappings of card indices to neural net inputs.
  *
@@ -1077,7 +1251,7 @@ static void setup_nets(game *g)
 		sprintf(buf, "Clock %d", i);
 		input_name[n++] = strdup(buf);
 	}
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		for (i = 0; i < MAX_GOAL; i++)
 		{
@@ -1212,7 +1386,7 @@ static void setup_nets(game *g)
 			input_name[n++] = strdup(buf);
 		}
 
-		if (exp_info[g->expanded].has_goals)
+		if (HAS_GOALS(g))
 		{
 			for (j = 0; j < MAX_GOAL; j++)
 			{
@@ -1221,7 +1395,7 @@ static void setup_nets(game *g)
 			}
 		}
 
-		if (exp_info[g->expanded].has_prestige)
+		if (HAS_PRESTIGE(g))
 		{
 			sprintf(buf, "%s prestige action used", name);
 			input_name[n++] = strdup(buf);
@@ -1251,7 +1425,7 @@ static void setup_nets(game *g)
 		}
 	}
 
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		for (i = 0; i < g->num_players; i++)
 		{
@@ -1321,7 +1495,7 @@ static void setup_nets(game *g)
 	}
 
 	/* Check for third expansion */
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		/* Use third expansion number of outputs */
 		outputs = g->advanced ? ROLE_OUT_ADV_EXP3 : ROLE_OUT_EXP3;
@@ -1430,7 +1604,7 @@ static void setup_nets(game *g)
 			input_name[n++] = strdup(buf);
 		}
 
-		if (exp_info[g->expanded].has_goals)
+		if (HAS_GOALS(g))
 		{
 			for (j = 0; j < MAX_GOAL; j++)
 			{
@@ -1439,7 +1613,7 @@ static void setup_nets(game *g)
 			}
 		}
 
-		if (exp_info[g->expanded].has_prestige)
+		if (HAS_PRESTIGE(g))
 		{
 			sprintf(buf, "%s prestige action used", name);
 			input_name[n++] = strdup(buf);
@@ -1472,7 +1646,7 @@ static void setup_nets(game *g)
 		}
 	}
 
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		for (i = 0; i < g->num_players; i++)
 		{
@@ -1546,7 +1720,7 @@ static void setup_nets(game *g)
 		sprintf(buf, "Clock %d", i);
 		input_name[n++] = strdup(buf);
 	}
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		for (i = 0; i < MAX_GOAL; i++)
 		{
@@ -1610,6 +1784,58 @@ static eval_cache *eval_hash[65536];
  */
 static eval_cache *opp_place_hash[65536];
 
+/*
+ * Cache entries not currently in use.
+ */
+static eval_cache *free_cache;
+
+/*
+ * Number of cache entries to allocate at once.
+ */
+#define CACHE_CHUNK 4096
+
+/*
+ * Number of heap allocations made by the AI while playing.
+ *
+ * Entries and buffers are reused once allocated, so this should stop
+ * increasing after the first few decisions.
+ */
+long ai_num_alloc;
+
+/*
+ * Get an unused cache entry.
+ */
+static eval_cache *new_cache_entry(void)
+{
+	eval_cache *e_ptr;
+	int i;
+
+	/* Check for no unused entries */
+	if (!free_cache)
+	{
+		/* Allocate block of entries */
+		e_ptr = (eval_cache *)malloc(sizeof(eval_cache) * CACHE_CHUNK);
+
+		/* Count allocation */
+		ai_num_alloc++;
+
+		/* Loop over new entries */
+		for (i = 0; i < CACHE_CHUNK; i++)
+		{
+			/* Add entry to unused list */
+			e_ptr[i].next = free_cache;
+			free_cache = &e_ptr[i];
+		}
+	}
+
+	/* Take first unused entry */
+	e_ptr = free_cache;
+	free_cache = e_ptr->next;
+
+	/* Return entry */
+	return e_ptr;
+}
+
 /*
  * Generic hash mixer.
  */
@@ -1688,6 +1914,90 @@ static uint64_t gen_hash(unsigned char *k, int length)
 }
 
 
+/*
+ * Hash the game state as seen by the given player.
+ *
+ * Only state that lasts from round to round is hashed: card locations,
+ * scores, goals and previous roles.  Temporary bonuses (bonus_military,
+ * bonus_military_xeno, bonus_reduce and the like), the draw order and
+ * the random seed are left out.  Equal hashes therefore make a decision
+ * computed ahead of time likely, not certain, to match a fresh one.
+ */
+uint64_t ai_state_hash(game *g, int who)
+{
+	player *p_ptr;
+	card *c_ptr;
+	unsigned char value[2048];
+	int len = 0;
+	int i, j;
+
+	/* Loop over cards */
+	for (i = 0; i < g->deck_size; i++)
+	{
+		/* Get card pointer */
+		c_ptr = &g->deck[i];
+
+		/* Add location and owner to value */
+		value[len++] = (unsigned char)c_ptr->where;
+		value[len++] = (unsigned char)c_ptr->owner;
+
+		/* Add card being covered to value */
+		value[len++] = (unsigned char)c_ptr->covering;
+
+		/* Add players who know the card's location to value */
+		value[len++] = (unsigned char)(c_ptr->misc & MISC_KNOWN_MASK);
+	}
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Get player pointer */
+		p_ptr = &g->p[i];
+
+		/* Add scores and once-per-game flags to value */
+		value[len++] = (unsigned char)p_ptr->vp;
+		value[len++] = (unsigned char)p_ptr->prestige;
+		value[len++] = (unsigned char)p_ptr->prestige_action_used;
+		value[len++] = (unsigned char)p_ptr->phase_bonus_used;
+
+		/* Add previous turn actions to value */
+		value[len++] = (unsigned char)p_ptr->prev_action[0];
+		value[len++] = (unsigned char)p_ptr->prev_action[1];
+
+		/* Loop over goals */
+		for (j = 0; j < MAX_GOAL; j++)
+		{
+			/* Skip inactive goals */
+			if (!g->goal_active[j]) continue;
+
+			/* Add goal claimed and progress to value */
+			value[len++] = (unsigned char)p_ptr->goal_claimed[j];
+			value[len++] = (unsigned char)p_ptr->goal_progress[j];
+		}
+	}
+
+	/* Loop over goals */
+	for (j = 0; j < MAX_GOAL; j++)
+	{
+		/* Skip inactive goals */
+		if (!g->goal_active[j]) continue;
+
+		/* Add goal availability and most progress to value */
+		value[len++] = (unsigned char)g->goal_avail[j];
+		value[len++] = (unsigned char)g->goal_most[j];
+	}
+
+	/* Add round number and VP pool to value */
+	value[len++] = (unsigned char)g->round;
+	value[len++] = (unsigned char)g->vp_pool;
+
+	/* Add viewing player to value */
+	value[len++] = (unsigned char)who;
+
+	/* Return hash of value */
+	return gen_hash(value, len);
+}
+
 /*
  * Look up a game state in the result cache.
  */
@@ -1778,7 +2088,7 @@ static eval_cache *lookup_eval(game *g, int who)
 	if (!e_ptr)
 	{
 		/* Make new entry */
-		e_ptr = (eval_cache *)malloc(sizeof(eval_cache));
+		e_ptr = new_cache_entry();
 
 		/* Set key of new entry */
 		e_ptr->key = key;
@@ -1850,7 +2160,7 @@ static eval_cache *lookup_opp_place(game *g, int who, int opp, int which,
 	if (!e_ptr)
 	{
 		/* Make new entry */
-		e_ptr = (eval_cache *)malloc(sizeof(eval_cache));
+		e_ptr = new_cache_entry();
 
 		/* Set key of new entry */
 		e_ptr->key = key;
@@ -1887,8 +2197,9 @@ static void clear_eval_cache(void)
 			/* Move row to next entry */
 			eval_hash[i] = e_ptr->next;
 
-			/* Delete entry */
-			free(e_ptr);
+			/* Return entry to unused list */
+			e_ptr->next = free_cache;
+			free_cache = e_ptr;
 		}
 	}
 }
@@ -1913,8 +2224,9 @@ static void clear_opp_place_cache(void)
 			/* Move row to next entry */
 			opp_place_hash[i] = e_ptr->next;
 
-			/* Delete entry */
-			free(e_ptr);
+			/* Return entry to unused list */
+			e_ptr->next = free_cache;
+			free_cache = e_ptr;
 		}
 	}
 }
@@ -2199,7 +2511,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	}
 
 	/* Check for goals in expansion */
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		/* Set inputs for claimed goals */
 		for (i = 0; i < MAX_GOAL; i++)
@@ -2210,7 +2522,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	}
 
 	/* Check for prestige in expansion */
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		/* Set input if player has used prestige/search action */
 		eval.input_value[n++] = (p_ptr->prestige_action_used ||
@@ -2292,6 +2604,9 @@ static double eval_game(game *g, int who)
 	int leader[MAX_PLAYER][MAX_LEADER];
 	double score;
 
+	/* Count evaluation */
+	num_evals++;
+
 	/* Lookup game state in cached results */
 	e_ptr = lookup_eval(g, who);
 
@@ -2299,12 +2614,12 @@ static double eval_game(game *g, int who)
 	/* Check for valid result */
 	if (e_ptr->score > -1)
 	{
-		eval_cache_hit++;
+		ai_cache_hit++;
 		return e_ptr->score;
 	}
 	else
 	{
-		eval_cache_miss++;
+		ai_cache_miss++;
 	}
 #endif
 
@@ -2369,7 +2684,7 @@ static double eval_game(game *g, int who)
 	}
 
 	/* Check for goals in expansion */
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		/* Set inputs for active goals */
 		for (i = 0; i < MAX_GOAL; i++)
@@ -2507,7 +2822,7 @@ static double eval_game(game *g, int who)
 	n = eval_game_leader(g, who, n, leader, LEADER_VP, 20);
 
 	/* Check for third expansion */
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		/* Add inputs for amount behind prestige leader */
 		n = eval_game_leader(g, who, n, leader, LEADER_PRESTIGE, 5);
@@ -2531,6 +2846,9 @@ static double eval_game(game *g, int who)
 		abort();
 	}
 
+	/* Continue from last state evaluated for this player */
+	use_net_slot(&eval, who);
+
 	/* Compute network */
 	compute_net(&eval);
 
@@ -2565,8 +2883,9 @@ static double eval_game(game *g, int who)
 static void perform_training(game *g, int who, double *desired)
 {
 	double target[MAX_PLAYER];
+	double *input[PAST_MAX], *output[PAST_MAX], weight[PAST_MAX];
 	double lambda = 1.0;
-	int i;
+	int i, n = 0;
 
 	/* Clear cached results of eval network */
 	clear_eval_cache();
@@ -2583,8 +2902,9 @@ static void perform_training(game *g, int who, double *desired)
 		/* Copy results to target array */
 		for (i = 0; i < g->num_players; i++) target[i] = desired[i];
 
-		/* Train current inputs with desired outputs */
-		train_net(&eval, 1.0, target);
+		/* Train current inputs (just stored) with desired outputs */
+		input[n] = eval.past_input[PAST_INDEX(&eval, eval.num_past - 1)];
+		weight[n++] = 1.0;
 
 		/* Reduce lambda for further training */
 		lambda *= 0.7;
@@ -2603,22 +2923,23 @@ static void perform_training(game *g, int who, double *desired)
 	for (i = eval.num_past - 2; i >= 0; i--)
 	{
 		/* Skip input sets that do not belong to us */
-		if (eval.past_input_player[i] != who) continue;
-
-		/* Copy past inputs to network */
-		memcpy(eval.input_value, eval.past_input[i],
-		       sizeof(double) * (eval.num_inputs + 1));
-
-		/* Compute network */
-		compute_net(&eval);
+		if (eval.past_input_player[PAST_INDEX(&eval, i)] != who)
+			continue;
 
-		/* Train */
-		train_net(&eval, lambda, target);
+		/* Add past inputs to batch */
+		input[n] = eval.past_input[PAST_INDEX(&eval, i)];
+		weight[n++] = lambda;
 
 		/* Reduce training amount as we go back in time */
 		lambda *= 0.7;
 	}
 
+	/* Every input set is trained towards the same target */
+	for (i = 0; i < n; i++) output[i] = target;
+
+	/* Train on all input sets at once */
+	train_net_batch(&eval, n, input, weight, output);
+
 	/* Apply accumulated training */
 	apply_training(&eval);
 }
@@ -2805,7 +3126,7 @@ static int predict_action_player(game *g, int who, int n, int *leader)
 	}
 
 	/* Check for goals in expansion */
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		/* Set inputs for claimed goals */
 		for (i = 0; i < MAX_GOAL; i++)
@@ -2816,7 +3137,7 @@ static int predict_action_player(game *g, int who, int n, int *leader)
 	}
 
 	/* Check for prestige in expansion */
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		/* Set input if player has used prestige/search action */
 		role.input_value[n++] = p_ptr->prestige_action_used ? 1 : -1;
@@ -2928,7 +3249,7 @@ static void predict_action(game *g, int who, double prob[MAX_ACTION],
 	n = predict_action_leader(g, who, n, leader, LEADER_VP, 20);
 
 	/* Check for third expansion */
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		/* Add inputs for amount behind prestige leader */
 		n = predict_action_leader(g, who, n, leader,
@@ -2990,7 +3311,7 @@ static void predict_action(game *g, int who, double prob[MAX_ACTION],
 	}
 
 	/* Check for goals in expansion */
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		/* Set inputs for active goals */
 		for (i = 0; i < MAX_GOAL; i++)
@@ -3090,6 +3411,9 @@ static void predict_action(game *g, int who, double prob[MAX_ACTION],
 		abort();
 	}
 
+	/* Continue from last prediction for this player */
+	use_net_slot(&role, who);
+
 	/* Compute role choice probabilities */
 	compute_net(&role);
 
@@ -3334,6 +3658,37 @@ static void ai_prepare_discard(game *g, int who)
 	discard_list[who][n].which = -1;
 }
 
+/*
+ * Order a list of cards from our hand so that the cards best to discard
+ * (according to the quick discard list) come first.
+ *
+ * Exhaustive discard searches try these cards first, so the best-so-far
+ * answer is a sensible one when the time budget runs out.
+ */
+static void order_quick_discard(int who, int list[], int num)
+{
+	int i, j, n = 0, x;
+
+	/* Loop over quick discard list */
+	for (i = 0; i < MAX_DECK && discard_list[who][i].which != -1 &&
+	            n < num; i++)
+	{
+		/* Look for card in given list */
+		for (j = n; j < num; j++)
+		{
+			/* Check for match */
+			if (list[j] == discard_list[who][i].which)
+			{
+				/* Move card to front */
+				x = list[n];
+				list[n++] = list[j];
+				list[j] = x;
+				break;
+			}
+		}
+	}
+}
+
 /*
  * Fill the advanced action combinations table.
  */
@@ -3628,6 +3983,9 @@ static void ai_choose_action_advanced(game *g, int who, int action[2], int one)
 	/* Loop over opponent's actions */
 	for (act = 0; act < n; act++)
 	{
+		/* Stop if decision is abandoned */
+		if (ai_check_interrupt()) break;
+
 		/* Compute probability of this combination */
 		prob = action_order[act].prob;
 
@@ -3850,6 +4208,9 @@ static void ai_choose_action_combo(game *g, int who, int current, double prob,
 			/* Resize list */
 			opponent_combo_size += 100;
 
+			/* Count allocation */
+			ai_num_alloc++;
+
 			/* Reallocate */
 			opponent_combos = (struct opponent_act *)realloc(
 			                   opponent_combos,
@@ -3983,6 +4344,8 @@ static void ai_choose_action(game *g, int who, int action[2], int one)
 	double most_prob, threshold = 1.0;
 	double *choice_prob[MAX_PLAYER];
 	action_prob *action_order[MAX_PLAYER];
+	double choice_row[MAX_PLAYER][ROLE_OUT_EXP3];
+	action_prob order_row[MAX_PLAYER][ROLE_OUT_EXP3];
 	double desired[ROLE_OUT_EXP3], sum = 0;
 	int i, current, best = -1, b_i, acts[MAX_PLAYER], no_act[MAX_PLAYER];;
 
@@ -4006,14 +4369,12 @@ static void ai_choose_action(game *g, int who, int action[2], int one)
 	dump_hand(g, who);
 #endif
 
-	/* Create rows of probabilities */
+	/* Set rows of probabilities */
 	for (i = 0; i < g->num_players; i++)
 	{
-		/* Create row */
-		choice_prob[i] =
-		            (double *)malloc(sizeof(double) * role.num_output);
-		action_order[i] =
-		   (action_prob *)malloc(sizeof(action_prob) * role.num_output);
+		/* Set row */
+		choice_prob[i] = choice_row[i];
+		action_order[i] = order_row[i];
 	}
 
 	/* Get action predictions */
@@ -4151,6 +4512,9 @@ static void ai_choose_action(game *g, int who, int action[2], int one)
 	/* Loop over opponent combos */
 	for (i = 0; i < opponent_combo_len; i++)
 	{
+		/* Stop if decision is abandoned */
+		if (ai_check_interrupt()) break;
+
 		/* Evaluate our actions */
 		if (!ai_choose_action_aux(&sim, who, opponent_combos[i].act,
 		                          opponent_combos[i].prob, &prob_used,
@@ -4161,13 +4525,6 @@ static void ai_choose_action(game *g, int who, int action[2], int one)
 		}
 	}
 
-	/* Free rows of probabilities */
-	for (i = 0; i < g->num_players; i++)
-	{
-		/* Free row */
-		free(choice_prob[i]);
-	}
-
 #ifdef DEBUG
 	printf("----- Prob used: %.2f\n", prob_used);
 
@@ -4302,6 +4659,9 @@ static void ai_choose_discard_aux(game *g, int who, int list[], int n, int c,
 			}
 		}
 
+		/* Return best choice so far if out of time */
+		if (*b_s > -1 && ai_out_of_time()) return;
+
 		/* Copy game */
 		simulate_game(&sim, g, who);
 
@@ -4577,6 +4937,9 @@ static void ai_choose_discard(game *g, int who, int list[], int *num,
 	/* Clear best score */
 	b_s = -1;
 
+	/* Try likely discards first when time is limited */
+	if (ai_deadline) order_quick_discard(who, list, *num);
+
 	/* Simulate game */
 	simulate_game(&sim, g, who);
 
@@ -4775,7 +5138,6 @@ static void ai_explore_sample_aux(game *g, int who, int draw, int keep,
                                   int discard_any, int discards[MAX_DECK])
 {
 	game sim, sim2;
-	card *c_ptr;
 	int list[MAX_DECK], num = 0, n = 0;
 	int i, x, b_i, discard, old_act;
 	int best;
@@ -4790,12 +5152,9 @@ static void ai_explore_sample_aux(game *g, int who, int draw, int keep,
 	/* Loop over cards */
 	for ( ; x != -1; x = g->deck[x].next)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[x];
-
 		/* Skip old cards if they can't be discarded */
-		if (c_ptr->start_where == WHERE_HAND &&
-		    c_ptr->start_owner == who && !discard_any) continue;
+		if (card_start_where(g, x) == WHERE_HAND &&
+		    card_start_owner(g, x) == who && !discard_any) continue;
 
 		/* Add card to list */
 		list[num++] = x;
@@ -4914,8 +5273,8 @@ static void ai_explore_sample_apply(game *g, int who, int draw, int keep,
  * Place a representative sample of possible cards from an Explore phase
  * in our hand.
  */
-static void ai_explore_sample(game *g, int who, int draw, int keep,
-                              int discard_any)
+static void ai_explore_sample_choose(game *g, int who, int draw, int keep,
+                                     int discard_any)
 {
 	game sim;
 	card *c_ptr;
@@ -5676,6 +6035,17 @@ static int ai_choose_place(game *g, int who, int list[], int num, int phase,
 	/* Get score for doing nothing */
 	b_s = eval_game(&sim2, who);
 
+	/*
+	 * Compute each placement from the state of doing nothing, which
+	 * differs from every placement by about one card.  The discard and
+	 * pay searches have no such common state: their candidates are
+	 * evaluated after the rest of the round, and starting from the
+	 * state on entry (or the first candidate) recomputes more inputs
+	 * than starting from the previous candidate does.
+	 */
+	use_net_slot(&eval, who);
+	push_net(&eval);
+
 #ifdef DEBUG
 	if (!g->simulation)
 	{
@@ -5721,6 +6091,10 @@ static int ai_choose_place(game *g, int who, int list[], int num, int phase,
 		/* Simulate rest of turn */
 		complete_turn(&sim2, COMPLETE_ROUND);
 
+		/* Return to state of doing nothing */
+		pop_net(&eval);
+		push_net(&eval);
+
 		/* Get score */
 		score = eval_game(&sim2, who);
 
@@ -5741,6 +6115,9 @@ static int ai_choose_place(game *g, int who, int list[], int num, int phase,
 		}
 	}
 
+	/* Done with state of doing nothing */
+	pop_net(&eval);
+
 	/* Return best choice */
 	return best;
 }
@@ -5790,6 +6167,9 @@ static void ai_choose_pay_aux2(game *g, int who, int which, int list[],
 			}
 		}
 
+		/* Return best choice so far if out of time */
+		if (*b_s > -1 && ai_out_of_time()) return;
+
 		/* Simulate game */
 		simulate_game(&sim, g, who);
 
@@ -5991,6 +6371,9 @@ static void ai_choose_pay(game *g, int who, int which, int list[], int *num,
 	int best = 0, best_special = 0, cs;
 	int payment[MAX_DECK], used[MAX_DECK];
 
+	/* Try likely discards first when time is limited */
+	if (ai_deadline) order_quick_discard(who, list, *num);
+
 	/* XXX Don't look at more than 15 cards to pay with */
 	if (*num > 15) *num = 15;
 
@@ -6246,6 +6629,9 @@ static void ai_choose_defend_aux2(game *g, int who, int which, int opponent,
 		/* Try varying number of payment cards */
 		for (i = 0; i <= num; i++)
 		{
+			/* Return best choice so far if out of time */
+			if (*b_s > -1 && ai_out_of_time()) return;
+
 			/* Simulate game */
 			simulate_game(&sim, g, who);
 
@@ -6329,6 +6715,9 @@ static void ai_choose_defend_aux2(game *g, int who, int which, int opponent,
 			}
 		}
 
+		/* Return best choice so far if out of time */
+		if (*b_s > -1 && ai_out_of_time()) return;
+
 		/* Simulate game */
 		simulate_game(&sim, g, who);
 
@@ -6441,11 +6830,27 @@ static void ai_choose_defend(game *g, int who, int which, int opponent,
 {
 	double b_s = -1;
 	int n = 0, n_used = 0;
-	int best = 0, best_special = 0, i;
+	int best = 0, best_special = 0, i, x;
+
+	/* Put cards best to discard first when time is limited */
+	if (ai_deadline) order_quick_discard(who, list, *num);
 
 	/* XXX Don't look at more than 30 cards to pay with */
 	if (*num > 30) *num = 30;
 
+	/* Try likely discards first when time is limited */
+	if (ai_deadline)
+	{
+		/* Search varies the last cards first, so reverse the list */
+		for (i = 0; i < *num / 2; i++)
+		{
+			/* Swap cards */
+			x = list[i];
+			list[i] = list[*num - 1 - i];
+			list[*num - 1 - i] = x;
+		}
+	}
+
 	/* Find best set of special abilities */
 	ai_choose_defend_aux1(g, who, which, opponent, deficit, list, *num,
 	                      special, *num_special, 0, 0, &best, &best_special,
@@ -7242,6 +7647,9 @@ static void ai_choose_consume_hand_aux(game *g, int who, int c_idx, int o_idx,
 			}
 		}
 
+		/* Return best choice so far if out of time */
+		if (*b_s > -1 && ai_out_of_time()) return;
+
 		/* Copy game */
 		simulate_game(&sim, g, who);
 
@@ -7357,6 +7765,9 @@ static void ai_choose_consume_hand(game *g, int who, int c_idx, int o_idx,
 		return;
 	}
 
+	/* Try likely discards first when time is limited */
+	if (ai_deadline) order_quick_discard(who, list, *num);
+
 	/* Loop over number of cards discardable */
 	for (i = 0; i <= o_ptr->times; i++)
 	{
@@ -7388,6 +7799,35 @@ static void ai_choose_consume_hand(game *g, int who, int c_idx, int o_idx,
 	*num = n;
 }
 
+/*
+ * Order a list of goods so that those preferred for consuming (according
+ * to good_better()) come first.
+ *
+ * Exhaustive good searches try these goods first, so the best-so-far
+ * answer is a sensible one when the time budget runs out.
+ */
+static void order_goods(game *g, int list[], int num)
+{
+	int i, j, x;
+
+	/* Loop over goods */
+	for (i = 0; i < num; i++)
+	{
+		/* Loop over later goods */
+		for (j = i + 1; j < num; j++)
+		{
+			/* Check for later good preferred */
+			if (good_better(g, list[i], list[j]) == 2)
+			{
+				/* Swap goods */
+				x = list[i];
+				list[i] = list[j];
+				list[j] = x;
+			}
+		}
+	}
+}
+
 /*
  * Helper function for ai_choose_good().
  */
@@ -7418,6 +7858,9 @@ static void ai_choose_good_aux(game *g, int who, int list[], int n, int c,
 			}
 		}
 
+		/* Return best choice so far if out of time */
+		if (*b_s > -1 && ai_out_of_time()) return;
+
 		/* Copy game */
 		simulate_game(&sim, g, who);
 
@@ -7488,6 +7931,9 @@ static void ai_choose_good(game *g, int who, int c_idx, int o_idx,
 		return;
 	}
 
+	/* Try preferred goods first when time is limited */
+	if (ai_deadline) order_goods(g, goods, *num);
+
 	/* Loop over allowed number of goods */
 	for (c = min; c <= max; c++)
 	{
@@ -8200,12 +8646,24 @@ static void ai_make_choice(game *g, int who, int type, int list[], int *nl,
                       int special[], int *ns, int arg1, int arg2, int arg3)
 {
 	player *p_ptr;
+	ai_prof mark;
 	int i, rv;
 	int *l_ptr;
 
 	/* Check for real game */
 	if (!g->simulation)
 	{
+		/* Start profiling decision */
+		profile_start(&mark);
+
+		/* Start timing decision */
+		ai_deadline = ai_time_budget > 0 ?
+		              profile_time() + ai_time_budget : 0;
+		ai_timed_out = 0;
+
+		/* Decision not abandoned */
+		ai_interrupted = 0;
+
 		/* Prepare quick discard list */
 		ai_prepare_discard(g, who);
 
@@ -8471,6 +8929,44 @@ static void ai_make_choice(game *g, int who, int type, int list[], int *nl,
 
 	/* Mark new size of choice log */
 	p_ptr->choice_size = l_ptr - p_ptr->choice_log;
+
+	/* Check for real game */
+	if (!g->simulation)
+	{
+		/* Stop timing decision */
+		ai_deadline = 0;
+		ai_timed_out = 0;
+
+		/* Add decision to profile */
+		profile_stop(type, &mark);
+	}
+}
+
+/*
+ * Place a sample of Explore phase cards in our hand, profiling the
+ * decision in real games.
+ */
+static void ai_explore_sample(game *g, int who, int draw, int keep,
+                              int discard_any)
+{
+	ai_prof mark;
+
+	/* Check for simulated game */
+	if (g->simulation)
+	{
+		/* Choose sample */
+		ai_explore_sample_choose(g, who, draw, keep, discard_any);
+		return;
+	}
+
+	/* Start profiling decision */
+	profile_start(&mark);
+
+	/* Choose sample */
+	ai_explore_sample_choose(g, who, draw, keep, discard_any);
+
+	/* Add decision to profile */
+	profile_stop(MAX_CHOICE, &mark);
 }
 
 /*
@@ -8478,10 +8974,7 @@ static void ai_make_choice(game *g, int who, int type, int list[], int *nl,
  */
 static void ai_game_over(game *g, int who)
 {
-	player *p_ptr;
-	double result[MAX_PLAYER], sum = 0.0;
-	int scores[MAX_PLAYER];
-	int max = 0, i, n;
+	double result[MAX_PLAYER];
 
 #if 0
 	if (who == 0)
@@ -8502,6 +8995,36 @@ static void ai_game_over(game *g, int who)
 	}
 #endif
 
+	/* Compute desired eval network outputs */
+	ai_game_result(g, who, result);
+
+	/* Perform final training */
+	perform_training(g, who, result);
+
+	/* Check for training done for all players */
+	if (who == g->num_players - 1)
+	{
+		/* Clear stored past inputs */
+		clear_store(&eval);
+		clear_store(&role);
+
+		/* Mark training iterations */
+		eval.num_training++;
+		role.num_training++;
+	}
+}
+
+/*
+ * Compute the final eval network outputs wanted for a finished game, from
+ * the given player's point of view.
+ */
+void ai_game_result(game *g, int who, double result[MAX_PLAYER])
+{
+	player *p_ptr;
+	double sum = 0.0;
+	int scores[MAX_PLAYER];
+	int max = 0, i, n;
+
 	/* Find maximum score */
 	for (i = 0; i < g->num_players; i++)
 	{
@@ -8543,47 +9066,279 @@ static void ai_game_over(game *g, int who)
 		/* Go to next player */
 		i = (i + 1) % g->num_players;
 	}
+}
 
-	/* Perform final training */
-	perform_training(g, who, result);
+/*
+ * Copy the networks in use back to their configuration slot.
+ */
+static void park_nets(void)
+{
+	net_config *c_ptr = active_config;
 
-	/* Check for training done for all players */
-	if (who == g->num_players - 1)
-	{
-		/* Clear stored past inputs */
-		clear_store(&eval);
-		clear_store(&role);
+	/* Check for no configuration in use */
+	if (!c_ptr) return;
 
-		/* Mark training iterations */
-		eval.num_training++;
-		role.num_training++;
-	}
+	/* Copy networks */
+	c_ptr->eval = eval;
+	c_ptr->role = role;
+
+	/* Copy input mappings */
+	memcpy(c_ptr->card_input, card_input, sizeof(card_input));
+	memcpy(c_ptr->good_input, good_input, sizeof(good_input));
+	c_ptr->num_c_input = num_c_input;
+	c_ptr->num_g_input = num_g_input;
+
+	/* No configuration in use */
+	active_config = NULL;
 }
 
 /*
- * Shutdown.
+ * Copy a loaded configuration to the networks in use.
  */
-static void ai_shutdown(game *g, int who)
+static void unpark_nets(net_config *c_ptr)
 {
-	char fname[1024];
-	static int saved;
+	/* Copy networks */
+	eval = c_ptr->eval;
+	role = c_ptr->role;
+
+	/* Copy input mappings */
+	memcpy(card_input, c_ptr->card_input, sizeof(card_input));
+	memcpy(good_input, c_ptr->good_input, sizeof(good_input));
+	num_c_input = c_ptr->num_c_input;
+	num_g_input = c_ptr->num_g_input;
+
+	/* Configuration is in use */
+	active_config = c_ptr;
+}
 
-	/* Check for already saved */
-	if (saved) return;
+/*
+ * Load the networks for a game into the networks in use.
+ */
+static void load_nets(game *g, double factor)
+{
+	char fname[1024], msg[1024];
+
+	/* Compute size and input names of networks */
+	setup_nets(g);
+
+	/* Keep hidden sums of each player's view separately */
+	make_net_slots(&eval, g->num_players);
+	make_net_slots(&role, g->num_players);
+
+	/* Set learning rate */
+	eval.alpha = 0.0001 * factor;
+#ifdef DEBUG
+	eval.alpha = 0.0;
+#endif
 
 	/* Create evaluator filename */
 	sprintf(fname, RFTGDIR "/network/rftg.eval.%d.%d%s.net", g->expanded,
 	        g->num_players, g->advanced ? "a" : "");
 
-	/* Save weights to disk */
-	save_net(&eval, fname);
+	/* Attempt to load network weights from disk */
+	if (load_net(&eval, fname))
+	{
+		/* Try looking under current directory */
+		sprintf(fname, "network/rftg.eval.%d.%d%s.net", g->expanded,
+		        g->num_players, g->advanced ? "a" : "");
+
+		/* Attempt to load again */
+		if (load_net(&eval, fname))
+		{
+			/* Print warning */
+			sprintf(msg, "Warning: Couldn't open %s\n", fname);
+			display_error(msg);
+
+			/* Perform initial training on new network */
+			initial_training(g);
+		}
+	}
+
+	/* Set learning rate */
+	role.alpha = 0.0005 * factor;
+#ifdef DEBUG
+	role.alpha = 0.0;
+#endif
 
 	/* Create predictor filename */
 	sprintf(fname, RFTGDIR "/network/rftg.role.%d.%d%s.net", g->expanded,
 	        g->num_players, g->advanced ? "a" : "");
 
+	/* Attempt to load network weights from disk */
+	if (load_net(&role, fname))
+	{
+		/* Try looking under current directory */
+		sprintf(fname, "network/rftg.role.%d.%d%s.net", g->expanded,
+		        g->num_players, g->advanced ? "a" : "");
+
+		/* Attempt to load again */
+		if (load_net(&role, fname))
+		{
+			/* Print warning */
+			sprintf(msg, "Warning: Couldn't open %s\n", fname);
+			display_error(msg);
+		}
+	}
+}
+
+/*
+ * Save the networks of a loaded configuration to disk.
+ */
+static void save_config(net_config *c_ptr)
+{
+	char fname[1024];
+
+	/* Create evaluator filename */
+	sprintf(fname, RFTGDIR "/network/rftg.eval.%d.%d%s.net",
+	        c_ptr->expanded, c_ptr->num_players,
+	        c_ptr->advanced ? "a" : "");
+
+	/* Save weights to disk */
+	save_net(&c_ptr->eval, fname);
+
+	/* Create predictor filename */
+	sprintf(fname, RFTGDIR "/network/rftg.role.%d.%d%s.net",
+	        c_ptr->expanded, c_ptr->num_players,
+	        c_ptr->advanced ? "a" : "");
+
 	/* Save weights to disk */
-	save_net(&role, fname);
+	save_net(&c_ptr->role, fname);
+}
+
+/*
+ * Use the networks for the given game's configuration.
+ *
+ * Each configuration is loaded the first time it is used and then kept,
+ * so that a process playing games of several configurations does not
+ * reload networks between games.  If more than ai_max_networks
+ * configurations are loaded, the least recently used one is freed
+ * (after being saved, if it has been learning).
+ */
+static void use_nets(game *g, double factor)
+{
+	net_config *c_ptr, *free_ptr = NULL, *old_ptr = NULL;
+	int i, n = 0;
+
+	/* Count use */
+	config_clock++;
+
+	/* Check for correct networks already in use */
+	if (active_config && active_config->num_players == g->num_players &&
+	    active_config->expanded == g->expanded &&
+	    active_config->advanced == g->advanced)
+	{
+		/* Mark use */
+		active_config->last_used = config_clock;
+		return;
+	}
+
+	/* Put away networks in use */
+	park_nets();
+
+	/* Cached evaluations were made with other networks */
+	clear_eval_cache();
+
+	/* Loop over configuration slots */
+	for (i = 0; i < MAX_NET_CONFIG; i++)
+	{
+		/* Get slot pointer */
+		c_ptr = &net_configs[i];
+
+		/* Check for unused slot */
+		if (!c_ptr->num_players)
+		{
+			/* Remember first unused slot */
+			if (!free_ptr) free_ptr = c_ptr;
+			continue;
+		}
+
+		/* Count loaded configurations */
+		n++;
+
+		/* Check for matching configuration */
+		if (c_ptr->num_players == g->num_players &&
+		    c_ptr->expanded == g->expanded &&
+		    c_ptr->advanced == g->advanced) break;
+
+		/* Track least recently used configuration */
+		if (!old_ptr || c_ptr->last_used < old_ptr->last_used)
+			old_ptr = c_ptr;
+	}
+
+	/* Check for configuration already loaded */
+	if (i < MAX_NET_CONFIG)
+	{
+		/* Use loaded networks */
+		unpark_nets(c_ptr);
+	}
+	else
+	{
+		/* Check for too many configurations loaded */
+		if (ai_max_networks > 0 && n >= ai_max_networks && old_ptr)
+		{
+			/* Check for networks that have learned */
+			if (old_ptr->eval.alpha || old_ptr->role.alpha)
+			{
+				/* Save what they learned */
+				save_config(old_ptr);
+			}
+
+			/* Free least recently used networks */
+			free_net(&old_ptr->eval);
+			free_net(&old_ptr->role);
+
+			/* Reuse slot */
+			old_ptr->num_players = 0;
+			free_ptr = old_ptr;
+		}
+
+		/* Get slot for new configuration */
+		c_ptr = free_ptr;
+
+		/* Remember configuration */
+		c_ptr->expanded = g->expanded;
+		c_ptr->num_players = g->num_players;
+		c_ptr->advanced = g->advanced;
+
+		/* Load networks into those in use */
+		load_nets(g, factor);
+
+		/* Mark configuration in use */
+		active_config = c_ptr;
+	}
+
+	/* Mark use */
+	c_ptr->last_used = config_clock;
+}
+
+/*
+ * Shutdown.
+ */
+static void ai_shutdown(game *g, int who)
+{
+	net_config *c_ptr;
+	static int saved;
+	int i;
+
+	/* Check for already saved */
+	if (saved) return;
+
+	/* Put away networks in use */
+	c_ptr = active_config;
+	park_nets();
+
+	/* Loop over loaded configurations */
+	for (i = 0; i < MAX_NET_CONFIG; i++)
+	{
+		/* Skip unused slots */
+		if (!net_configs[i].num_players) continue;
+
+		/* Save networks */
+		save_config(&net_configs[i]);
+	}
+
+	/* Keep using same networks */
+	if (c_ptr) unpark_nets(c_ptr);
 
 	printf("Role hit: %d, Role miss: %d\n", role_hit, role_miss);
 	printf("Role avg: %f\n", role_avg / (role_hit + role_miss));
@@ -8610,6 +9365,82 @@ decisions ai_func =
 	NULL,
 };
 
+/*
+ * Set the eval network's inputs (and compute its outputs) for the given
+ * player's view of a real game.
+ *
+ * Used by the offline trainer, which reads the inputs from the network.
+ */
+net *ai_eval_inputs(game *g, int who)
+{
+	/* Clear cached results of eval network */
+	clear_eval_cache();
+
+	/* Evaluate game */
+	eval_game(g, who);
+
+	/* Return network */
+	return &eval;
+}
+
+/*
+ * Set the role network's inputs (and compute its outputs) for predicting
+ * the given player's actions at the start of a round.
+ *
+ * Used by the offline trainer, which reads the inputs from the network.
+ */
+net *ai_role_inputs(game *g, int who)
+{
+	double prob[MAX_ACTION];
+
+	/* Prepare quick discard list */
+	ai_prepare_discard(g, who);
+
+	/* Clear sample results */
+	ai_sample_clear();
+
+	/* Clear placement cache */
+	clear_opp_place_cache();
+
+	/* Predict player's actions */
+	predict_action(g, who, prob, who);
+
+	/* Return network */
+	return &role;
+}
+
+/*
+ * Return the role network output matching the actions the given player
+ * chose in the previous round, or -1 if none does.
+ */
+int ai_role_output(game *g, int who)
+{
+	int *act = g->p[who].prev_action;
+	int i;
+
+	/* Loop over network outputs */
+	for (i = 0; i < role.num_output; i++)
+	{
+		/* Check for advanced game */
+		if (g->advanced)
+		{
+			/* Check for same pair of actions (in either order) */
+			if ((adv_combo[i][0] == act[0] &&
+			     adv_combo[i][1] == act[1]) ||
+			    (adv_combo[i][0] == act[1] &&
+			     adv_combo[i][1] == act[0])) return i;
+		}
+		else
+		{
+			/* Check for same action */
+			if (role_out[i] == act[0]) return i;
+		}
+	}
+
+	/* No match */
+	return -1;
+}
+
 /*
  * Provide debugging information.
  */
@@ -8831,6 +9662,9 @@ static void initial_training(game *g)
 	g->deck_size = 0;
 	g->cur_action = 0;
 	memset(g->deck, 0, sizeof(card) * MAX_DECK);
+	memset(g->owner_set, 0, sizeof(g->owner_set));
+	memset(g->where_set, 0, sizeof(g->where_set));
+	memset(g->moved_set, 0, sizeof(g->moved_set));
 	memset(g->goal_active, 0, sizeof(int) * MAX_GOAL);
 	memset(g->goal_avail, 0, sizeof(int) * MAX_GOAL);
 
@@ -8850,6 +9684,7 @@ static void initial_training(game *g)
 		/* Clear player's card stacks */
 		for (j = 0; j < MAX_WHERE; j++) g->p[i].head[j] = -1;
 		for (j = 0; j < MAX_WHERE; j++) g->p[i].start_head[j] = -1;
+		g->p[i].start_saved = 0;
 	}
 
 	/* Perform several training iterations */
@@ -22,6 +22,7 @@
 
 #include "rftg.h"
 #include "comm.h"
+#include <poll.h>
 
 /*
  * Our copy of game data.
@@ -43,6 +44,60 @@ static char buf[BUF_LEN];
  */
 static int buf_full;
 
+/*
+ * Predicted game state for the next round, used while pondering.
+ */
+static game ponder_game;
+
+/*
+ * Choice log holding the pondered role choice.
+ */
+static int ponder_log[4096];
+
+/*
+ * Length of the pondered answer (zero if none).
+ */
+static int ponder_len;
+
+/*
+ * State hash and "select last" argument the answer was computed for.
+ */
+static uint64_t ponder_key;
+static int ponder_last;
+
+/*
+ * Round most recently pondered (we ponder at most once per round).
+ */
+static int ponder_round = -1;
+
+/*
+ * Pondering statistics.
+ */
+static int num_ponder, num_ponder_hit, num_ponder_abort, num_role_asked;
+
+/*
+ * AI profile has been requested with SIGUSR1.
+ */
+static volatile sig_atomic_t profile_wanted;
+
+/*
+ * Print pondering statistics and the AI profile.
+ */
+static void print_profile(FILE *fff)
+{
+	/* Report pondering statistics */
+	fprintf(fff, "AI client: pondered %d role choices (%d abandoned), "
+	        "%d of %d predicted (%.1f%%)\n", num_ponder, num_ponder_abort,
+	        num_ponder_hit, num_role_asked,
+	        num_role_asked ? 100.0 * num_ponder_hit / num_role_asked : 0.0);
+
+	/* Report decisions cut short by time budget */
+	fprintf(fff, "AI client: %ld decisions out of time\n", ai_num_timeout);
+
+	/* Report time spent on each kind of decision */
+	ai_print_profile(fff);
+}
+
 /*
  * Send message to server.
  */
@@ -69,6 +124,9 @@ void send_msg(int fd, char *msg)
 			/* Check for broken pipe */
 			if (errno == EPIPE) return;
 
+			/* Retry if interrupted by a signal */
+			if (errno == EINTR) continue;
+
 			/* Error */
 			perror("send");
 			return;
@@ -439,9 +497,42 @@ format_error:
 		exit(1);
 	}
 
-	/* Ask AI for decision */
-	ai_func.make_choice(&real_game, player_us, type, list, &num,
-	                    special, &num_special, arg1, arg2, arg3);
+	/* Check for role choice */
+	if (type == CHOICE_ACTION)
+	{
+		/* Count role choices */
+		num_role_asked++;
+
+		/* Check for pondered answer to the same question */
+		if (ponder_len && ponder_last == arg1 &&
+		    ponder_key == ai_state_hash(&real_game, player_us))
+		{
+			/* Copy pondered answer to choice log */
+			memcpy(&p_ptr->choice_log[p_ptr->choice_size], ponder_log,
+			       sizeof(int) * ponder_len);
+			p_ptr->choice_size += ponder_len;
+
+			/* Copy hand size noted by AI */
+			p_ptr->low_hand = ponder_game.p[player_us].low_hand;
+
+			/* Count hit */
+			num_ponder_hit++;
+
+			/* Do not ask AI again */
+			type = -1;
+		}
+
+		/* Pondered answer is used up (or wrong) */
+		ponder_len = 0;
+	}
+
+	/* Check for decision still needed */
+	if (type >= 0)
+	{
+		/* Ask AI for decision */
+		ai_func.make_choice(&real_game, player_us, type, list, &num,
+		                    special, &num_special, arg1, arg2, arg3);
+	}
 
 	/* Start reply */
 	ptr = msg;
@@ -537,6 +628,9 @@ static void message_read(char *data)
 		/* Game is over */
 		case MSG_GAMEOVER:
 
+			/* Report statistics */
+			print_profile(stdout);
+
 			/* Done */
 			exit(0);
 			break;
@@ -608,8 +702,8 @@ static void data_ready(void)
 	/* Check for error */
 	if (x <= 0)
 	{
-		/* Check for try again error */
-		if (x < 0 && errno == EAGAIN) return;
+		/* Check for try again or interrupted read */
+		if (x < 0 && (errno == EAGAIN || errno == EINTR)) return;
 
 		/* Check for server disconnect */
 		if (x == 0) exit(0);
@@ -657,6 +751,111 @@ static void data_ready(void)
 	}
 }
 
+/*
+ * Check whether a message from the server is waiting to be read.
+ */
+static int input_pending(void)
+{
+	struct pollfd pfd;
+
+	/* Check standard input */
+	pfd.fd = 0;
+	pfd.events = POLLIN;
+
+	/* Poll without waiting */
+	return poll(&pfd, 1, 0) != 0;
+}
+
+/*
+ * Think about our next role choice while waiting for the server.
+ *
+ * Once the last selected phase of a round has been reached, the
+ * remaining changes to the game state are usually small.  Predict that
+ * the next round begins with the current state and choose our role(s)
+ * ahead of time.  The answer is used if the state matches when the
+ * server actually asks.
+ *
+ * This is done at most once per round, and the search is abandoned as
+ * soon as a message from the server arrives.
+ */
+static void ponder(void)
+{
+	player *p_ptr;
+	uint64_t key;
+	int i, act[2], num = 2, last;
+
+	/* Check for game not started or over */
+	if (!real_game.deck_size || real_game.game_over) return;
+
+	/* Do not ponder before the round's phases begin */
+	if (real_game.cur_action < 0) return;
+
+	/* Loop over remaining phases */
+	for (i = real_game.cur_action + 1; i < MAX_ACTION; i++)
+	{
+		/* Wait until no phases remain */
+		if (real_game.action_selected[i]) return;
+	}
+
+	/* Check for round already pondered */
+	if (ponder_round == real_game.round) return;
+
+	/* Do not ponder again this round */
+	ponder_round = real_game.round;
+
+	/* Copy current state */
+	copy_game(&ponder_game, &real_game);
+
+	/* Predict next round */
+	ponder_game.round++;
+	ponder_game.cur_action = ACT_ROUND_START;
+
+	/* Clear selected actions */
+	for (i = 0; i < MAX_ACTION; i++) ponder_game.action_selected[i] = 0;
+
+	/* Get hash of predicted state */
+	key = ai_state_hash(&ponder_game, player_us);
+
+	/* Check for "select last" */
+	last = count_active_flags(&ponder_game, player_us, FLAG_SELECT_LAST);
+
+	/* Get player pointer */
+	p_ptr = &ponder_game.p[player_us];
+
+	/* Write answer to separate log */
+	p_ptr->choice_log = ponder_log;
+	p_ptr->choice_size = p_ptr->choice_pos = 0;
+
+	/* Stop searching when the server sends a message */
+	ai_interrupt = input_pending;
+
+	/* Ask AI for role choice */
+	ai_func.make_choice(&ponder_game, player_us, CHOICE_ACTION, act, &num,
+	                    NULL, NULL, last, 0, 0);
+
+	/* Searches may no longer be interrupted */
+	ai_interrupt = NULL;
+
+	/* Check for abandoned search */
+	if (ai_interrupted)
+	{
+		/* Count abandoned ponders */
+		num_ponder_abort++;
+
+		/* Forget partial answer */
+		ponder_len = 0;
+		return;
+	}
+
+	/* Remember answer */
+	ponder_len = p_ptr->choice_size;
+	ponder_key = key;
+	ponder_last = last;
+
+	/* Count ponders */
+	num_ponder++;
+}
+
 /*
  * Print errors to standard output.
  */
@@ -689,11 +888,22 @@ int game_rand(game *g)
 	return simple_rand(&g->random_seed);
 }
 
+/*
+ * Note that the AI profile should be printed.
+ */
+static void request_profile(int sig)
+{
+	/* Set flag for main loop */
+	profile_wanted = 1;
+}
+
 /*
  * Read messages from server and have AI answer choice queries.
  */
 int main(int argc, char *argv[])
 {
+	struct sigaction sa;
+	sigset_t mask;
 	int i;
 #if 0
 	volatile int f = 1;
@@ -701,6 +911,35 @@ int main(int argc, char *argv[])
 	while (f) ;
 #endif
 
+	/* Print AI profile on SIGUSR1, interrupting a waiting read */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = request_profile;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+
+	/* Accept profile requests (the server blocks them until now) */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	sigprocmask(SIG_UNBLOCK, &mask, NULL);
+
+	/* Parse arguments */
+	for (i = 1; i < argc; i++)
+	{
+		/* Check for time budget */
+		if (!strcmp(argv[i], "-t") && i + 1 < argc)
+		{
+			/* Set wall time allowed per decision */
+			ai_time_budget = atof(argv[++i]);
+		}
+
+		/* Check for network limit */
+		else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+		{
+			/* Set number of network configurations kept loaded */
+			ai_max_networks = atoi(argv[++i]);
+		}
+	}
+
 	/* Read card database */
 	if (read_cards(NULL) < 0)
 	{
@@ -708,6 +947,9 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
+	/* Game messages are never shown */
+	real_game.silent = 1;
+
 	/* Create choice logs */
 	for (i = 0; i < MAX_PLAYER; i++)
 	{
@@ -718,6 +960,19 @@ int main(int argc, char *argv[])
 	/* Loop forever */
 	while (1)
 	{
+		/* Check for profile request */
+		if (profile_wanted)
+		{
+			/* Clear request */
+			profile_wanted = 0;
+
+			/* Print profile */
+			print_profile(stdout);
+		}
+
+		/* Think ahead while no message is waiting */
+		if (!buf_full && !input_pending()) ponder();
+
 		/* Try to read data */
 		data_ready();
 	}
@@ -0,0 +1,614 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2015 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "rftg.h"
+#include "net.h"
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/*
+ * Self-play benchmark.
+ *
+ * Plays a fixed set of seeds for every game configuration that has
+ * shipped networks, and prints one line of JSON per configuration.
+ */
+
+/*
+ * Number of timed decision kinds (every choice type plus explore sample).
+ */
+#define NUM_TIMED      (MAX_CHOICE + 1)
+
+/*
+ * Index used for explore sample decisions.
+ */
+#define TIMED_EXPLORE  MAX_CHOICE
+
+/*
+ * Latency samples (in seconds) of each decision kind.
+ */
+static double *latency[NUM_TIMED];
+static int num_latency[NUM_TIMED], max_latency[NUM_TIMED];
+
+/*
+ * Print messages?
+ */
+int verbose = 0;
+
+/*
+ * Print errors to standard error.
+ */
+void display_error(char *msg)
+{
+	/* Forward message */
+	fprintf(stderr, "%s", msg);
+}
+
+/*
+ * Print messages to standard error.
+ */
+void message_add(game *g, char *msg)
+{
+	/* Print if verbose flag set */
+	if (verbose) fprintf(stderr, "%s", msg);
+}
+
+/*
+ * Print messages to standard error.
+ */
+void message_add_formatted(game *g, char *msg, char *tag)
+{
+	/* Print without formatting */
+	message_add(g, msg);
+}
+
+/*
+ * Use simple random number generator.
+ */
+int game_rand(game *g)
+{
+	/* Call simple random number generator */
+	return simple_rand(&g->random_seed);
+}
+
+/*
+ * Return the current time in seconds from a monotonic clock.
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	/* Get time */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	/* Convert to seconds */
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Record one latency sample.
+ */
+static void add_latency(int kind, double t)
+{
+	/* Grow sample array if needed */
+	if (num_latency[kind] == max_latency[kind])
+	{
+		/* Double size */
+		max_latency[kind] = max_latency[kind] ? 2 * max_latency[kind] :
+		                                        256;
+
+		/* Reallocate */
+		latency[kind] = (double *)realloc(latency[kind],
+		                          sizeof(double) * max_latency[kind]);
+	}
+
+	/* Store sample */
+	latency[kind][num_latency[kind]++] = t;
+}
+
+/*
+ * Compare two latency samples.
+ */
+static int cmp_latency(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	/* Compare */
+	return (x > y) - (x < y);
+}
+
+/*
+ * Return the given percentile of a sorted sample array.
+ */
+static double percentile(double *list, int n, double pct)
+{
+	int i;
+
+	/* Check for no samples */
+	if (!n) return 0.0;
+
+	/* Compute index of sample */
+	i = (int)(pct / 100.0 * (n - 1) + 0.5);
+
+	/* Return sample */
+	return list[i];
+}
+
+/*
+ * Time a choice made by the AI.
+ */
+static void bench_make_choice(game *g, int who, int type, int list[], int *nl,
+                              int special[], int *ns, int arg1, int arg2,
+                              int arg3)
+{
+	double start = now();
+
+	/* Ask AI */
+	ai_func.make_choice(g, who, type, list, nl, special, ns,
+	                    arg1, arg2, arg3);
+
+	/* Record time taken */
+	add_latency(type, now() - start);
+}
+
+/*
+ * Time an explore sample decision made by the AI.
+ */
+static void bench_explore_sample(game *g, int who, int draw, int keep,
+                                 int discard_any)
+{
+	double start = now();
+
+	/* Ask AI */
+	ai_func.explore_sample(g, who, draw, keep, discard_any);
+
+	/* Record time taken */
+	add_latency(TIMED_EXPLORE, now() - start);
+}
+
+/*
+ * Decision functions that time the AI.
+ */
+static decisions bench_func;
+
+/*
+ * Replayed games never ask for fresh answers.
+ */
+static void replay_make_choice(game *g, int who, int type, int list[],
+                               int *nl, int special[], int *ns, int arg1,
+                               int arg2, int arg3)
+{
+	/* Error */
+	display_error("Replay ran past end of choice log!\n");
+	exit(1);
+}
+
+/*
+ * Replayed games have nothing to do on rotation.
+ */
+static void replay_notify_rotation(game *g, int who)
+{
+}
+
+/*
+ * Decision functions for fast-forward replays.
+ */
+static decisions replay_func =
+{
+	NULL,
+	replay_notify_rotation,
+	NULL,
+	replay_make_choice,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+};
+
+/*
+ * Fast-forward a finished game from its starting state and choice logs.
+ *
+ * The final scores are checked against the original game, and the time
+ * taken is returned.
+ */
+static double replay_game(game *start_game, game *done)
+{
+	static game replay;
+	player *p_ptr;
+	double start;
+	int i, j;
+
+	/* Copy starting state */
+	replay = *start_game;
+
+	/* Loop over players */
+	for (i = 0; i < replay.num_players; i++)
+	{
+		/* Get player pointer */
+		p_ptr = &replay.p[i];
+
+		/* Find player's (possibly rotated) seat at end of game */
+		for (j = 0; done->p[j].choice_log != p_ptr->choice_log; j++);
+
+		/* Replay whole log */
+		p_ptr->choice_size = done->p[j].choice_size;
+		p_ptr->choice_pos = 0;
+		p_ptr->choice_unread_pos = 0;
+
+		/* Answers come from the log only */
+		p_ptr->control = &replay_func;
+	}
+
+	/* Skip player notifications */
+	replay.fast_forward = 1;
+
+	/* Start timer */
+	start = now();
+
+	/* Begin game */
+	begin_game(&replay);
+
+	/* Play game rounds until finished */
+	while (game_round(&replay));
+
+	/* Score game */
+	score_game(&replay);
+
+	/* Stop timer */
+	start = now() - start;
+
+	/* Loop over players */
+	for (i = 0; i < replay.num_players; i++)
+	{
+		/* Get player pointer */
+		p_ptr = &replay.p[i];
+
+		/* Find player in original game */
+		for (j = 0; done->p[j].choice_log != p_ptr->choice_log; j++);
+
+		/* Check for different result or unused choices */
+		if (p_ptr->end_vp != done->p[j].end_vp ||
+		    p_ptr->choice_pos != p_ptr->choice_size)
+		{
+			/* Error */
+			display_error("Replayed game does not match original!\n");
+			exit(1);
+		}
+	}
+
+	/* Return time taken */
+	return start;
+}
+
+/*
+ * Return whether networks for the given configuration can be found.
+ */
+static int have_networks(int expansion, int num_players, int advanced)
+{
+	char fname[1024];
+	FILE *fff;
+
+	/* Try installed and current directory */
+	sprintf(fname, RFTGDIR "/network/rftg.eval.%d.%d%s.net", expansion,
+	        num_players, advanced ? "a" : "");
+
+	/* Attempt to open */
+	fff = fopen(fname, "r");
+
+	/* Try current directory */
+	if (!fff)
+	{
+		/* Create local filename */
+		sprintf(fname, "network/rftg.eval.%d.%d%s.net", expansion,
+		        num_players, advanced ? "a" : "");
+
+		/* Attempt to open */
+		fff = fopen(fname, "r");
+	}
+
+	/* Check for failure */
+	if (!fff) return 0;
+
+	/* Close file */
+	fclose(fff);
+
+	/* Success */
+	return 1;
+}
+
+/*
+ * Play the seed set for one configuration and print its results.
+ */
+static void bench_config(int expansion, int num_players, int advanced, int n)
+{
+	game my_game;
+	static game start_game;
+	char buf[1024], *names[MAX_PLAYER];
+	long computes, hits, misses, allocs, decisions_made = 0;
+	struct rusage usage;
+	double start, elapsed, replay_time = 0.0;
+	int i, j, first;
+
+	/* Clear latency samples */
+	for (i = 0; i < NUM_TIMED; i++) num_latency[i] = 0;
+
+	/* Set game options */
+	my_game.num_players = num_players;
+	my_game.expanded = expansion;
+	my_game.advanced = advanced;
+	my_game.promo = 0;
+	my_game.goal_disabled = 0;
+	my_game.takeover_disabled = 0;
+	my_game.camp = NULL;
+
+	/* Do not generate messages unless they are printed */
+	my_game.silent = !verbose;
+
+	/* Call initialization functions */
+	for (i = 0; i < num_players; i++)
+	{
+		/* Create player name */
+		sprintf(buf, "Player %d", i);
+
+		/* Set player name */
+		my_game.p[i].name = strdup(buf);
+		names[i] = my_game.p[i].name;
+
+		/* Set player interfaces to timed AI functions */
+		my_game.p[i].control = &bench_func;
+
+		/* Initialize AI without learning */
+		my_game.p[i].control->init(&my_game, i, 0.0);
+
+		/* Create choice log for player */
+		my_game.p[i].choice_log = (int *)malloc(sizeof(int) * 4096);
+
+		/* Clear choice log size and position */
+		my_game.p[i].choice_size = 0;
+		my_game.p[i].choice_pos = 0;
+	}
+
+	/* Remember counters at start */
+	computes = net_num_computes;
+	hits = ai_cache_hit;
+	misses = ai_cache_miss;
+	allocs = ai_num_alloc;
+
+	/* Start timer */
+	start = now();
+
+	/* Play a game for each seed */
+	for (i = 0; i < n; i++)
+	{
+		/* Use fixed seed */
+		my_game.random_seed = i + 1;
+
+		/* Initialize game */
+		init_game(&my_game);
+
+		/* Game is simulated */
+		my_game.session_id = -2;
+
+		/* Save starting state for replay */
+		start_game = my_game;
+
+		/* Begin game */
+		begin_game(&my_game);
+
+		/* Play game rounds until finished */
+		while (game_round(&my_game));
+
+		/* Score game */
+		score_game(&my_game);
+
+		/* Declare winner */
+		declare_winner(&my_game);
+
+		/* Time fast-forward through the finished game */
+		replay_time += replay_game(&start_game, &my_game);
+
+		/* Call player game over functions */
+		for (j = 0; j < num_players; j++)
+		{
+			/* Call game over function */
+			my_game.p[j].control->game_over(&my_game, j);
+
+			/* Clear choice log */
+			my_game.p[j].choice_size = 0;
+			my_game.p[j].choice_pos = 0;
+
+			/* Reset name */
+			my_game.p[j].name = names[j];
+		}
+	}
+
+	/* Stop timer (not counting replays) */
+	elapsed = now() - start - replay_time;
+
+	/* Compute counter differences */
+	computes = net_num_computes - computes;
+	hits = ai_cache_hit - hits;
+	misses = ai_cache_miss - misses;
+	allocs = ai_num_alloc - allocs;
+
+	/* Count decisions and sort samples */
+	for (i = 0; i < NUM_TIMED; i++)
+	{
+		/* Add to total */
+		decisions_made += num_latency[i];
+
+		/* Sort samples */
+		qsort(latency[i], num_latency[i], sizeof(double), cmp_latency);
+	}
+
+	/* Get resource usage */
+	getrusage(RUSAGE_SELF, &usage);
+
+	/* Print configuration and totals */
+	printf("{\"expansion\": %d, \"players\": %d, \"advanced\": %d, "
+	       "\"games\": %d, \"seconds\": %.3f, \"games_per_sec\": %.3f, "
+	       "\"decisions\": %ld, \"decisions_per_sec\": %.1f, "
+	       "\"compute_net\": %ld, \"cache_hits\": %ld, "
+	       "\"cache_misses\": %ld, \"cache_hit_rate\": %.4f, "
+	       "\"ai_allocs\": %ld, \"peak_rss_kb\": %ld, "
+	       "\"replay_ms\": %.3f, \"latency\": {",
+	       expansion, num_players, advanced, n, elapsed,
+	       elapsed > 0 ? n / elapsed : 0.0,
+	       decisions_made,
+	       elapsed > 0 ? decisions_made / elapsed : 0.0,
+	       computes, hits, misses,
+	       hits + misses ? (double)hits / (hits + misses) : 0.0,
+	       allocs, usage.ru_maxrss, 1000 * replay_time / n);
+
+	/* Print latency of each decision kind seen */
+	for (i = 0, first = 1; i < NUM_TIMED; i++)
+	{
+		/* Skip kinds never asked */
+		if (!num_latency[i]) continue;
+
+		/* Print entry */
+		printf("%s\"%s\": {\"n\": %d, \"p50_ms\": %.3f, "
+		       "\"p99_ms\": %.3f}", first ? "" : ", ",
+		       i < MAX_CHOICE ? choice_name[i] : "explore",
+		       num_latency[i],
+		       1000 * percentile(latency[i], num_latency[i], 50),
+		       1000 * percentile(latency[i], num_latency[i], 99));
+
+		/* No longer first */
+		first = 0;
+	}
+
+	/* End line */
+	printf("}}\n");
+	fflush(stdout);
+
+	/*
+	 * Free choice logs and names.
+	 *
+	 * The AI shutdown function is not called, since it would save
+	 * the network weights over the shipped files.
+	 */
+	for (i = 0; i < num_players; i++)
+	{
+		/* Free choice log and name */
+		free(my_game.p[i].choice_log);
+		free(names[i]);
+	}
+}
+
+/*
+ * Run the benchmark over all (or selected) configurations.
+ */
+int main(int argc, char *argv[])
+{
+	int i, e, p, a, n = 10;
+	int only_e = -1, only_p = -1, only_a = -1;
+
+	/* Read card database */
+	if (read_cards(NULL) < 0)
+	{
+		/* Exit */
+		exit(1);
+	}
+
+	/* Parse arguments */
+	for (i = 1; i < argc; i++)
+	{
+		/* Check for verbosity */
+		if (!strcmp(argv[i], "-v"))
+		{
+			/* Set verbose flag */
+			verbose++;
+		}
+
+		/* Check for number of players */
+		else if (!strcmp(argv[i], "-p"))
+		{
+			/* Restrict number of players */
+			only_p = atoi(argv[++i]);
+		}
+
+		/* Check for advanced game */
+		else if (!strcmp(argv[i], "-a"))
+		{
+			/* Restrict to advanced games */
+			only_a = 1;
+		}
+
+		/* Check for expansion level */
+		else if (!strcmp(argv[i], "-e"))
+		{
+			/* Restrict expansion level */
+			only_e = atoi(argv[++i]);
+		}
+
+		/* Check for number of games */
+		else if (!strcmp(argv[i], "-n"))
+		{
+			/* Set number of games per configuration */
+			n = atoi(argv[++i]);
+		}
+	}
+
+	/* Copy AI decision functions */
+	bench_func = ai_func;
+
+	/* Time choices */
+	bench_func.make_choice = bench_make_choice;
+	bench_func.explore_sample = bench_explore_sample;
+
+	/* Loop over expansions */
+	for (e = 0; e < MAX_EXPANSION; e++)
+	{
+#ifdef FIXED_EXPANSION
+		/* Skip expansions not supported by this build */
+		if (e != FIXED_EXPANSION) continue;
+#endif
+
+		/* Skip unselected expansions */
+		if (only_e >= 0 && e != only_e) continue;
+
+		/* Loop over number of players */
+		for (p = 2; p <= exp_info[e].max_players; p++)
+		{
+			/* Skip unselected player counts */
+			if (only_p >= 0 && p != only_p) continue;
+
+			/* Loop over advanced flag */
+			for (a = 0; a < 2; a++)
+			{
+				/* Advanced game is two players only */
+				if (a && p != 2) continue;
+
+				/* Skip unselected advanced flag */
+				if (only_a >= 0 && a != only_a) continue;
+
+				/* Skip configurations without networks */
+				if (!have_networks(e, p, a)) continue;
+
+				/* Play configuration */
+				bench_config(e, p, a, n);
+			}
+		}
+	}
+
+	/* Done */
+	return 0;
+}
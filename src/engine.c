@@ -26,47 +26,17 @@
 /*
  * Information about each expansion.
  */
+#define EXP_INFO(x, name_, abbr, order, max, goals, takeovers, prestige, \
+                 start) \
+	[x] = { \
+		.name = name_, .short_name = abbr, .display_order = order, \
+		.max_players = max, .has_goals = goals, \
+		.has_takeovers = takeovers, .has_prestige = prestige, \
+		.has_start_world_choice = start, \
+	},
 expansion exp_info[] =
 {
-	{
-		"Base game only", "Base", 0,
-		.max_players = 4,
-	},
-	{
-		"The Gathering Storm", "TGS", 1,
-		.max_players = 5,
-		.has_goals = 1,
-	},
-	{
-		"Rebel vs Imperium", "RvI", 6,
-		.max_players = 6,
-		.has_goals = 1,
-		.has_takeovers = 1,
-		.has_start_world_choice = 1,
-	},
-	{
-		"The Brink of War", "BoW", 2,
-		.max_players = 6,
-		.has_goals = 1,
-		.has_takeovers = 1,
-		.has_prestige = 1,
-		.has_start_world_choice = 1,
-	},
-	{
-		"Alien Artifacts", "AA", 3,
-		.max_players = 5,
-		.has_start_world_choice = 1,
-	},
-	{
-		"Xeno Invasion", "XI", 4,
-		.max_players = 5,
-		.has_start_world_choice = 1,
-	},
-	{
-		"Rebel vs Imperium only", "RvIo", 5,
-		.max_players = 5,
-		.has_takeovers = 1,
-	},
+	EXP_TABLE(EXP_INFO)
 };
 
 /*
@@ -97,6 +67,38 @@ char *location_names[MAX_WHERE] =
 	"Campaign",
 };
 
+/*
+ * Short names of choice types, used in statistics output.
+ */
+char *choice_name[MAX_CHOICE] =
+{
+	"action",
+	"start",
+	"discard",
+	"save",
+	"discard_prestige",
+	"place",
+	"payment",
+	"settle",
+	"takeover",
+	"defend",
+	"takeover_prevent",
+	"upgrade",
+	"trade",
+	"consume",
+	"consume_hand",
+	"good",
+	"lucky",
+	"ante",
+	"keep",
+	"windfall",
+	"produce",
+	"discard_produce",
+	"search_type",
+	"search_keep",
+	"oort_kind",
+};
+
 void dump_hand(game *g, int who)
 {
 	card *c_ptr;
@@ -182,7 +184,7 @@ int simple_rand(unsigned int *seed)
  */
 int goals_enabled(game *g)
 {
-	return exp_info[g->expanded].has_goals && !g->goal_disabled;
+	return HAS_GOALS(g) && !g->goal_disabled;
 }
 
 /*
@@ -190,7 +192,50 @@ int goals_enabled(game *g)
  */
 int takeovers_enabled(game *g)
 {
-	return exp_info[g->expanded].has_takeovers && !g->takeover_disabled;
+	return HAS_TAKEOVERS(g) && !g->takeover_disabled;
+}
+
+/*
+ * Copy a game state.
+ *
+ * Only the cards actually in use are copied, which is much less than
+ * the full deck array for games with few (or no) expansions.
+ */
+void copy_game(game *dest, game *src)
+{
+	/* Copy everything preceding the deck */
+	memcpy(dest, src, offsetof(game, deck));
+
+	/* Copy cards in use */
+	memcpy(dest->deck, src->deck, sizeof(card) * src->deck_size);
+}
+
+/*
+ * Count the bits set in a word.
+ */
+int bit_count(uint64_t x)
+{
+	int n = 0;
+
+	/* Clear lowest set bit until none remain */
+	for ( ; x; x &= x - 1) n++;
+
+	/* Return count */
+	return n;
+}
+
+/*
+ * Return the position of the lowest bit set in a (nonzero) word.
+ */
+int bit_first(uint64_t x)
+{
+	int n = 0;
+
+	/* Shift until lowest bit is set */
+	for ( ; !(x & 1); x >>= 1) n++;
+
+	/* Return position */
+	return n;
 }
 
 /*
@@ -242,16 +287,13 @@ static int draw_empty(game *g)
  */
 int count_player_area(game *g, int who, int where)
 {
-	int x, n = 0;
-
-	/* Get first card of area chosen */
-	x = g->p[who].head[where];
+	int i, n = 0;
 
-	/* Loop until end of list */
-	for ( ; x != -1; x = g->deck[x].next)
+	/* Loop over words of card sets */
+	for (i = 0; i < DECK_WORDS; i++)
 	{
-		/* Count card */
-		n++;
+		/* Count cards both owned by player and in location */
+		n += BIT_COUNT(g->owner_set[who][i] & g->where_set[where][i]);
 	}
 
 	/* Return count */
@@ -263,16 +305,24 @@ int count_player_area(game *g, int who, int where)
  */
 int player_has(game *g, int who, design *d_ptr)
 {
-	int x;
-
-	/* Get first active card */
-	x = g->p[who].head[WHERE_ACTIVE];
+	uint64_t bits;
+	int i, x;
 
-	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].next)
+	/* Loop over words of card sets */
+	for (i = 0; i < DECK_WORDS; i++)
 	{
-		/* Check for matching type */
-		if (g->deck[x].d_ptr == d_ptr) return 1;
+		/* Get player's active cards in this word */
+		bits = g->owner_set[who][i] & g->where_set[WHERE_ACTIVE][i];
+
+		/* Loop over cards */
+		for ( ; bits; bits &= bits - 1)
+		{
+			/* Get card index */
+			x = i * 64 + BIT_FIRST(bits);
+
+			/* Check for matching type */
+			if (g->deck[x].d_ptr == d_ptr) return 1;
+		}
 	}
 
 	/* Assume not */
@@ -289,10 +339,10 @@ int count_active_flags(game *g, int who, int flags)
 	int x, count = 0;
 
 	/* Start at first active card */
-	x = g->p[who].start_head[WHERE_ACTIVE];
+	x = start_list_head(g, who, WHERE_ACTIVE);
 
 	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].start_next)
+	for ( ; x != -1; x = start_list_next(g, who, WHERE_ACTIVE, x))
 	{
 		/* Check for correct flags */
 		if ((g->deck[x].d_ptr->flags & flags) == flags) count++;
@@ -361,6 +411,116 @@ int prestige_on_tile(game *g, int who)
 	return 1;
 }
 
+/*
+ * Remember a card's location as of the start of the phase.
+ *
+ * This must be called before a card's location is changed.  Cards that
+ * have not moved since the phase began are at their start location.
+ */
+static void save_start(game *g, int which)
+{
+	card *c_ptr;
+
+	/* Do nothing if already moved this phase */
+	if (SET_HAS(g->moved_set, which)) return;
+
+	/* Get card pointer */
+	c_ptr = &g->deck[which];
+
+	/* Copy current location */
+	c_ptr->start_owner = c_ptr->owner;
+	c_ptr->start_where = c_ptr->where;
+
+	/* Mark card as moved */
+	SET_ADD(g->moved_set, which);
+}
+
+/*
+ * Remember a player's list of cards in a location as of the start of
+ * the phase.
+ *
+ * This must be called before the list is changed.  Lists that have not
+ * changed since the phase began are their own start of phase list.
+ */
+static void save_start_list(game *g, int who, int where)
+{
+	player *p_ptr;
+	int x;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Do nothing if already saved this phase */
+	if (p_ptr->start_saved & (1 << where)) return;
+
+	/* Copy start of list */
+	p_ptr->start_head[where] = p_ptr->head[where];
+
+	/* Loop over cards in list */
+	for (x = p_ptr->head[where]; x != -1; x = g->deck[x].next)
+	{
+		/* Copy next card */
+		g->deck[x].start_next = g->deck[x].next;
+	}
+
+	/* Mark list as saved */
+	p_ptr->start_saved |= 1 << where;
+}
+
+/*
+ * Return a card's owner as of the start of the phase.
+ */
+int card_start_owner(game *g, int which)
+{
+	/* Check for card moved this phase */
+	if (SET_HAS(g->moved_set, which)) return g->deck[which].start_owner;
+
+	/* Card has not moved */
+	return g->deck[which].owner;
+}
+
+/*
+ * Return a card's location as of the start of the phase.
+ */
+int card_start_where(game *g, int which)
+{
+	/* Check for card moved this phase */
+	if (SET_HAS(g->moved_set, which)) return g->deck[which].start_where;
+
+	/* Card has not moved */
+	return g->deck[which].where;
+}
+
+/*
+ * Return the first card in a player's location as of the start of the phase.
+ */
+int start_list_head(game *g, int who, int where)
+{
+	player *p_ptr;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Check for list changed this phase */
+	if (p_ptr->start_saved & (1 << where)) return p_ptr->start_head[where];
+
+	/* List has not changed */
+	return p_ptr->head[where];
+}
+
+/*
+ * Return the card following the given one in a player's location as of
+ * the start of the phase.
+ */
+int start_list_next(game *g, int who, int where, int x)
+{
+	/* Check for list changed this phase */
+	if (g->p[who].start_saved & (1 << where)) return g->deck[x].start_next;
+
+	/* List has not changed */
+	return g->deck[x].next;
+}
+
 /*
  * Refresh the draw deck.
  */
@@ -370,7 +530,7 @@ static void refresh_draw(game *g)
 	int i;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Send message */
 		message_add_formatted(g, "Refreshing draw deck.\n", FORMAT_EM);
@@ -385,6 +545,9 @@ static void refresh_draw(game *g)
 		/* Skip cards not in discard pile */
 		if (c_ptr->where != WHERE_DISCARD) continue;
 
+		/* Remember start of phase location */
+		save_start(g, i);
+
 		/* Move card to draw deck */
 		c_ptr->where = WHERE_DECK;
 
@@ -438,6 +601,9 @@ static int random_draw(game *g)
 		if (!(n--)) break;
 	}
 
+	/* Remember start of phase location */
+	save_start(g, i);
+
 	/* Clear chosen card's location */
 	c_ptr->where = -1;
 
@@ -522,6 +688,9 @@ int first_draw(game *g)
 		if (i == g->deck_size) return -1;
 	}
 
+	/* Remember start of phase location */
+	save_start(g, i);
+
 	/* Clear chosen card's location */
 	c_ptr->where = -1;
 
@@ -533,7 +702,7 @@ int first_draw(game *g)
 }
 
 /*
- * Move a card, keeping track of linked lists.
+ * Move a card, keeping track of linked lists and card sets.
  *
  * This MUST be called when a card is moved to or from a player.
  */
@@ -541,51 +710,68 @@ void move_card(game *g, int which, int owner, int where)
 {
 	player *p_ptr;
 	card *c_ptr;
-	int x;
 
 	/* Get card pointer */
 	c_ptr = &g->deck[which];
 
+	/* Remember start of phase location */
+	save_start(g, which);
+
 	/* Check for current owner */
 	if (c_ptr->owner != -1)
 	{
+		/* Remember start of phase list */
+		save_start_list(g, c_ptr->owner, c_ptr->where);
+
 		/* Get pointer of current owner */
 		p_ptr = &g->p[c_ptr->owner];
 
-		/* Find card in list */
-		x = p_ptr->head[c_ptr->where];
-
 		/* Check for beginning of list */
-		if (x == which)
+		if (c_ptr->prev == -1)
 		{
 			/* Adjust list forward */
 			p_ptr->head[c_ptr->where] = c_ptr->next;
-			c_ptr->next = -1;
 		}
 		else
 		{
-			/* Loop until moved card is found */
-			while (g->deck[x].next != which)
-			{
-				/* Move forward */
-				x = g->deck[x].next;
-			}
-
 			/* Remove moved card from list */
-			g->deck[x].next = c_ptr->next;
-			c_ptr->next = -1;
+			g->deck[c_ptr->prev].next = c_ptr->next;
+		}
+
+		/* Check for following card */
+		if (c_ptr->next != -1)
+		{
+			/* Link following card backward */
+			g->deck[c_ptr->next].prev = c_ptr->prev;
 		}
+
+		/* Card is no longer in a list */
+		c_ptr->next = c_ptr->prev = -1;
+
+		/* Remove card from old owner and location sets */
+		SET_REMOVE(g->owner_set[c_ptr->owner], which);
+		SET_REMOVE(g->where_set[c_ptr->where], which);
 	}
 
 	/* Check for new owner */
 	if (owner != -1)
 	{
+		/* Remember start of phase list */
+		save_start_list(g, owner, where);
+
 		/* Get player pointer of new owner */
 		p_ptr = &g->p[owner];
 
 		/* Add card to beginning of list */
 		c_ptr->next = p_ptr->head[where];
 		p_ptr->head[where] = which;
+
+		/* Link old first card backward */
+		if (c_ptr->next != -1) g->deck[c_ptr->next].prev = which;
+
+		/* Add card to new owner and location sets */
+		SET_ADD(g->owner_set[owner], which);
+		SET_ADD(g->where_set[where], which);
 	}
 
 	/* Adjust location */
@@ -608,9 +794,15 @@ void move_start(game *g, int which, int owner, int where)
 	/* Get card pointer */
 	c_ptr = &g->deck[which];
 
+	/* Remember current start of phase location */
+	save_start(g, which);
+
 	/* Check for current owner */
 	if (c_ptr->start_owner != -1)
 	{
+		/* Remember start of phase list */
+		save_start_list(g, c_ptr->start_owner, c_ptr->start_where);
+
 		/* Get pointer of current owner */
 		p_ptr = &g->p[c_ptr->start_owner];
 
@@ -643,6 +835,9 @@ void move_start(game *g, int which, int owner, int where)
 	/* Check for new owner */
 	if (owner != -1)
 	{
+		/* Remember start of phase list */
+		save_start_list(g, owner, where);
+
 		/* Get player pointer of new owner */
 		p_ptr = &g->p[owner];
 
@@ -691,6 +886,9 @@ int draw_card(game *g, int who, char *reason)
 		/* Get card pointer */
 		c_ptr = &g->deck[which];
 
+		/* Remember start of phase location */
+		save_start(g, which);
+
 		/* Move card to discard to simulate deck cycling */
 		c_ptr->where = WHERE_DISCARD;
 
@@ -715,7 +913,7 @@ int draw_card(game *g, int who, char *reason)
 	c_ptr->misc |= 1 << who;
 
 	/* Check for real game and reason */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		if (reason)
 		{
@@ -753,7 +951,7 @@ void draw_cards(game *g, int who, int num, char *reason)
 	char msg[1024];
 
 	/* Check for real game and reason */
-	if (!g->simulation && reason)
+	if (GAME_MESSAGES(g) && reason)
 	{
 		/* Format message */
 		sprintf(msg, "%s receives %d card%s from %s.\n",
@@ -782,7 +980,7 @@ void gain_prestige(game *g, int who, int num, char *reason)
 	p_ptr->prestige += num;
 
 	/* Check for real game and reason */
-	if (!g->simulation && reason)
+	if (GAME_MESSAGES(g) && reason)
 	{
 		/* Format message */
 		sprintf(msg, "%s receives %d prestige from %s.\n",
@@ -811,7 +1009,7 @@ static void gain_vps(game *g, int who, int num, char *reason)
 	g->vp_pool -= num;
 
 	/* Check for simulated game and reason */
-	if (!g->simulation && reason)
+	if (GAME_MESSAGES(g) && reason)
 	{
 		sprintf(msg, "%s receives %d VP%s from %s.\n",
 		        g->p[who].name, num, PLURAL(num), reason);
@@ -847,7 +1045,7 @@ void check_prestige(game *g)
 	int i, max = 0, num = 0;
 
 	/* Do nothing unless third expansion is present */
-	if (!exp_info[g->expanded].has_prestige) return;
+	if (!HAS_PRESTIGE(g)) return;
 
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
@@ -896,7 +1094,7 @@ void start_prestige(game *g)
 	int i, max = 0, num = 0, card_bonus = -1;
 
 	/* Do nothing unless third expansion is present */
-	if (!exp_info[g->expanded].has_prestige) return;
+	if (!HAS_PRESTIGE(g)) return;
 
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
@@ -937,7 +1135,7 @@ void start_prestige(game *g)
 			g->vp_pool--;
 
 			/* Start message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s earns VP", p_ptr->name);
@@ -950,7 +1148,7 @@ void start_prestige(game *g)
 				card_bonus = i;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Add to message */
 					strcat(msg, " and card");
@@ -958,7 +1156,7 @@ void start_prestige(game *g)
 			}
 
 			/* Finish message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Complete message */
 				strcat(msg, " for Prestige Leader.\n");
@@ -988,28 +1186,35 @@ void start_prestige(game *g)
 
 /*
  * Clear temp flags on all cards and player structures.
+ *
+ * Current card locations become the start of phase locations.  Only
+ * cards that have moved during the phase, or are owned by a player, can
+ * have temp flags set, so other cards are not visited.
  */
 void clear_temp(game *g)
 {
 	player *p_ptr;
-	card *c_ptr;
+	uint64_t bits;
 	int i, j;
 
-	/* Loop over cards */
-	for (i = 0; i < g->deck_size; i++)
+	/* Loop over words of card sets */
+	for (i = 0; i < DECK_WORDS; i++)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[i];
+		/* Start with cards moved this phase */
+		bits = g->moved_set[i];
 
-		/* Copy current location */
-		c_ptr->start_owner = c_ptr->owner;
-		c_ptr->start_where = c_ptr->where;
+		/* Add cards owned by each player */
+		for (j = 0; j < g->num_players; j++) bits |= g->owner_set[j][i];
 
-		/* Copy next card */
-		c_ptr->start_next = c_ptr->next;
+		/* Loop over cards */
+		for ( ; bits; bits &= bits - 1)
+		{
+			/* Clear all temp misc flags */
+			g->deck[i * 64 + BIT_FIRST(bits)].misc &= MISC_TEMP_MASK;
+		}
 
-		/* Clear all temp misc flags */
-		c_ptr->misc &= MISC_TEMP_MASK;
+		/* No cards have moved in new phase */
+		g->moved_set[i] = 0;
 	}
 
 	/* Loop over players */
@@ -1034,12 +1239,8 @@ void clear_temp(game *g)
 		p_ptr->hand_military_spent = 0;
 		p_ptr->military_spent = 0;
 
-		/* Loop over location heads */
-		for (j = 0; j < MAX_WHERE; j++)
-		{
-			/* Copy start of list */
-			p_ptr->start_head[j] = p_ptr->head[j];
-		}
+		/* No lists have changed in new phase */
+		p_ptr->start_saved = 0;
 	}
 }
 
@@ -1205,7 +1406,7 @@ static void perform_debug_moves(game *g, int who)
 				l_ptr += 4;
 
 				/* Don't do anything if expansion does not have prestige */
-				if (!exp_info[g->expanded].has_prestige) break;
+				if (!HAS_PRESTIGE(g)) break;
 
 				/* Format message */
 				sprintf(msg, "%s takes a prestige.\n", g->p[who].name);
@@ -1388,6 +1589,9 @@ static int ask_player(game *g, int who, int type, int list[], int *nl,
 		return extract_choice(g, who, type, list, nl, special, ns);
 	}
 
+	/* Fresh answers end any fast-forward replay */
+	g->fast_forward = 0;
+
 	/* Ask player for answer */
 	p_ptr->control->make_choice(g, who, type, list, nl, special, ns,
 	                            arg1, arg2, arg3);
@@ -1432,6 +1636,9 @@ static void send_choice(game *g, int who, int type, int list[], int *nl,
 		return;
 	}
 
+	/* Fresh answers end any fast-forward replay */
+	g->fast_forward = 0;
+
 	/* Ask player for answer */
 	p_ptr->control->make_choice(g, who, type, list, nl, special, ns,
 	                            arg1, arg2, arg3);
@@ -1448,6 +1655,9 @@ static void wait_for_all(game *g)
 	player *p_ptr;
 	int i;
 
+	/* Answers are already in the logs when fast-forwarding */
+	if (g->fast_forward) return;
+
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
 	{
@@ -1463,6 +1673,30 @@ static void wait_for_all(game *g)
 	}
 }
 
+/*
+ * Return whether a player's answers are being replayed from the choice log
+ * in a fast-forward.  A player with nothing left in the log ends it.
+ */
+static int fast_forwarding(game *g, int who)
+{
+	player *p_ptr;
+
+	/* Check for no fast-forward */
+	if (!g->fast_forward) return 0;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Check for unconsumed choices in log */
+	if (p_ptr->choice_pos < p_ptr->choice_size) return 1;
+
+	/* Player must be notified from now on */
+	g->fast_forward = 0;
+
+	/* Not fast-forwarding */
+	return 0;
+}
+
 /*
  * Return a list of cards in the given player's given area.
  */
@@ -1490,29 +1724,34 @@ static int get_player_area(game *g, int who, int list[MAX_DECK], int where)
 int has_good(game *g, int who, int type)
 {
 	card *c_ptr;
-	int x;
-
-	/* Start at first active card */
-	x = g->p[who].head[WHERE_ACTIVE];
+	uint64_t bits;
+	int i;
 
-	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].next)
+	/* Loop over words of card sets */
+	for (i = 0; i < DECK_WORDS; i++)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[x];
+		/* Get player's active cards in this word */
+		bits = g->owner_set[who][i] & g->where_set[WHERE_ACTIVE][i];
 
-		/* Skip cards without goods */
-		if (!c_ptr->num_goods) continue;
+		/* Loop over cards */
+		for ( ; bits; bits &= bits - 1)
+		{
+			/* Get card pointer */
+			c_ptr = &g->deck[i * 64 + BIT_FIRST(bits)];
 
-		/* Skip cards with wrong good type */
-		if (c_ptr->d_ptr->good_type != GOOD_ANY &&
-		    c_ptr->d_ptr->good_type != type) continue;
+			/* Skip cards without goods */
+			if (!c_ptr->num_goods) continue;
 
-		/* Skip cards that are newly-placed */
-		if (c_ptr->misc & MISC_UNPAID) continue;
+			/* Skip cards with wrong good type */
+			if (c_ptr->d_ptr->good_type != GOOD_ANY &&
+			    c_ptr->d_ptr->good_type != type) continue;
 
-		/* Good found */
-		return 1;
+			/* Skip cards that are newly-placed */
+			if (c_ptr->misc & MISC_UNPAID) continue;
+
+			/* Good found */
+			return 1;
+		}
 	}
 
 	/* No goods */
@@ -1525,26 +1764,31 @@ int has_good(game *g, int who, int type)
 int count_goods(game *g, int who, int type)
 {
 	card *c_ptr;
-	int x, n = 0;
-
-	/* Start at first active card */
-	x = g->p[who].head[WHERE_ACTIVE];
+	uint64_t bits;
+	int i, n = 0;
 
-	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].next)
+	/* Loop over words of card sets */
+	for (i = 0; i < DECK_WORDS; i++)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[x];
+		/* Get player's active cards in this word */
+		bits = g->owner_set[who][i] & g->where_set[WHERE_ACTIVE][i];
 
-		/* Skip cards with wrong good type */
-		if (c_ptr->d_ptr->good_type != GOOD_ANY &&
-		    c_ptr->d_ptr->good_type != type) continue;
+		/* Loop over cards */
+		for ( ; bits; bits &= bits - 1)
+		{
+			/* Get card pointer */
+			c_ptr = &g->deck[i * 64 + BIT_FIRST(bits)];
 
-		/* Skip cards that are newly-placed */
-		if (c_ptr->misc & MISC_UNPAID) continue;
+			/* Skip cards with wrong good type */
+			if (c_ptr->d_ptr->good_type != GOOD_ANY &&
+			    c_ptr->d_ptr->good_type != type) continue;
+
+			/* Skip cards that are newly-placed */
+			if (c_ptr->misc & MISC_UNPAID) continue;
 
-		/* Increase number of goods */
-		n += c_ptr->num_goods;
+			/* Increase number of goods */
+			n += c_ptr->num_goods;
+		}
 	}
 
 	/* Return number found */
@@ -1609,7 +1853,7 @@ void discard_callback(game *g, int who, int list[], int num)
 		move_card(g, list[i], -1, WHERE_DISCARD);
 
 		/* Message */
-		if (!g->simulation && g->p[who].control->private_message)
+		if (GAME_MESSAGES(g) && g->p[who].control->private_message)
 		{
 			/* Format message */
 			sprintf(msg, "%s discards %s.\n",
@@ -1671,10 +1915,10 @@ int get_powers(game *g, int who, int phase, power_where *w_list)
 	int x, i, n = 0;
 
 	/* Get first active card */
-	x = g->p[who].start_head[WHERE_ACTIVE];
+	x = start_list_head(g, who, WHERE_ACTIVE);
 
 	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].start_next)
+	for ( ; x != -1; x = start_list_next(g, who, WHERE_ACTIVE, x))
 	{
 		/* Get card pointer */
 		c_ptr = &g->deck[x];
@@ -1770,7 +2014,7 @@ void discard_produce_chosen(game *g, int who, int world, int discard,
 	move_card(g, discard, -1, WHERE_DISCARD);
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Private message */
 		if (g->p[who].control->private_message)
@@ -1855,7 +2099,7 @@ int action_legal_helper(game *g, int who, int action)
 	if (raw_action == ACT_SEARCH)
 	{
 		/* Check for correct expansion */
-		if (g->expanded != EXP_BOW) return 0;
+		if (GAME_EXP(g) != EXP_BOW) return 0;
 
 		/* No prestige Search combo */
 		if (action & ACT_PRESTIGE) return 0;
@@ -1868,7 +2112,7 @@ int action_legal_helper(game *g, int who, int action)
 	if (action & ACT_PRESTIGE)
 	{
 		/* Check for correct expansion */
-		if (g->expanded != EXP_BOW) return 0;
+		if (GAME_EXP(g) != EXP_BOW) return 0;
 
 		/* Check for prestige action available */
 		return g->p[who].prestige > 0 && !g->p[who].prestige_action_used;
@@ -2132,6 +2376,9 @@ void phase_search(game *g)
 	int category, which;
 	int i, j, second, third, match, keep;
 
+	/* Search action only exists in Brink of War */
+	if (GAME_EXP(g) != EXP_BOW) return;
+
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
 	{
@@ -2160,7 +2407,7 @@ void phase_search(game *g)
 		second = third = 0;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s searches for %s.\n", p_ptr->name,
@@ -2180,7 +2427,7 @@ void phase_search(game *g)
 			if (which == -1)
 			{
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "Search fails for %s.\n",
@@ -2210,7 +2457,7 @@ void phase_search(game *g)
 			match = search_match(g, which, category);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Check for match */
 				if (match)
@@ -2265,7 +2512,7 @@ void phase_search(game *g)
 				if (!keep)
 				{
 					/* Message */
-					if (!g->simulation)
+					if (GAME_MESSAGES(g))
 					{
 						/* Format message */
 						sprintf(msg,
@@ -2302,7 +2549,7 @@ void phase_search(game *g)
 			c_ptr->misc |= 1 << i;
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s takes %s.\n", p_ptr->name,
@@ -2345,7 +2592,6 @@ void phase_search(game *g)
 void phase_explore(game *g)
 {
 	player *p_ptr;
-	card *c_ptr;
 	power_where w_list[100];
 	power *o_ptr;
 	int i, j, x, n, draw, keep, drawn[MAX_PLAYER], kept[MAX_PLAYER];
@@ -2401,7 +2647,7 @@ void phase_explore(game *g)
 			gain_prestige(g, i, o_ptr->value, NULL);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s discards to gain prestige from %s.\n",
@@ -2479,7 +2725,7 @@ void phase_explore(game *g)
 		/* Assume player has no "discard any" power, unless the expansion is XI,
 		 * in which case "discard any" power always applies
 		 */
-		discard_any = g->expanded == EXP_XI ? 1 : 0;
+		discard_any = GAME_EXP(g) == EXP_XI ? 1 : 0;
 
 		/* Check for chosen "+1 keep" explore */
 		if (player_chose(g, i, ACT_EXPLORE_1_1)) keep += 1;
@@ -2529,12 +2775,9 @@ void phase_explore(game *g)
 		/* Loop over cards */
 		for ( ; x != -1; x = g->deck[x].next)
 		{
-			/* Get card pointer */
-			c_ptr = &g->deck[x];
-
 			/* Skip cards already in hand unless discarding any */
-			if (c_ptr->start_where == WHERE_HAND &&
-			    c_ptr->start_owner == i && !discard_any)
+			if (card_start_where(g, x) == WHERE_HAND &&
+			    card_start_owner(g, x) == i && !discard_any)
 				continue;
 
 			/* Add card to list */
@@ -2570,7 +2813,7 @@ void phase_explore(game *g)
 		}
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Check for discarding any */
 			if (any[i])
@@ -2641,7 +2884,7 @@ void place_card(game *g, int who, int which)
 	if (c_ptr->d_ptr->flags & FLAG_WINDFALL) add_good(g, which);
 
 	/* Check for third expansion */
-	if (exp_info[g->expanded].has_prestige)
+	if (HAS_PRESTIGE(g))
 	{
 		/* Check for prestige from card */
 		if (c_ptr->d_ptr->flags & FLAG_PRESTIGE)
@@ -2832,7 +3075,7 @@ int devel_callback(game *g, int who, int which, int list[], int num,
 				move_card(g, special[i], -1, WHERE_DISCARD);
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards %s.\n",
@@ -2865,7 +3108,7 @@ int devel_callback(game *g, int who, int which, int list[], int num,
 				num_consume_special = 2;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards a Rare good to "
@@ -2911,7 +3154,7 @@ int devel_callback(game *g, int who, int which, int list[], int num,
 	}
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Private message */
 		if (g->p[who].control->private_message)
@@ -2991,7 +3234,7 @@ int devel_callback(game *g, int who, int which, int list[], int num,
 			move_card(g, list[0], who, WHERE_SAVED);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s saves 1 card under Galactic Scavengers.\n",
@@ -3086,7 +3329,7 @@ static void pay_devel(game *g, int who, int cost)
 	if (cost == 0 && !num_special)
 	{
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s pays 0 for %s.\n",
@@ -3331,7 +3574,7 @@ void phase_develop(game *g)
 			player_discard(g, i, explore);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s discards %d card%s.\n", g->p[i].name,
@@ -3475,7 +3718,7 @@ void phase_develop(game *g)
 		if (!asked[i])
 		{
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s does not place a development.\n",
@@ -3506,7 +3749,7 @@ void phase_develop(game *g)
 			p_ptr->skip_develop = 1;
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s does not place a development.\n",
@@ -3520,7 +3763,7 @@ void phase_develop(game *g)
 		}
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s places %s.\n", p_ptr->name,
@@ -3547,8 +3790,8 @@ void phase_develop(game *g)
 		/* Skip players who are not placing anything */
 		if (p_ptr->placing == -1) continue;
 
-		/* Check for prepare function */
-		if (p_ptr->control->prepare_phase)
+		/* Check for prepare function (unless answers are logged) */
+		if (p_ptr->control->prepare_phase && !fast_forwarding(g, i))
 		{
 			/* Ask player to prepare answers for payment */
 			p_ptr->control->prepare_phase(g, i, PHASE_DEVELOP,
@@ -4671,7 +4914,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				if (cost < 0) cost = 0;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s uses %s.\n", p_ptr->name,
@@ -4689,7 +4932,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				move_card(g, special[i], -1, WHERE_DISCARD);
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards %s.\n", p_ptr->name,
@@ -4791,7 +5034,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				p_ptr->bonus_reduce += o_ptr->value;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards a Genes good to "
@@ -4818,7 +5061,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				p_ptr->bonus_military += o_ptr->value;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards a Novelty good for "
@@ -4848,7 +5091,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				p_ptr->bonus_military += o_ptr->value;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards a Rare good for "
@@ -4898,7 +5141,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				}
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards an Alien good for "
@@ -4929,7 +5172,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				p_ptr->bonus_military += o_ptr->value;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s spends prestige for "
@@ -5236,7 +5479,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 		}
 
 		/* Private message */
-		if (!g->simulation && g->p[who].control->private_message)
+		if (GAME_MESSAGES(g) && g->p[who].control->private_message)
 		{
 			/* Format message */
 			sprintf(msg, "%s discards %s.\n", p_ptr->name,
@@ -5258,7 +5501,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 	if (i < p_ptr->low_hand) p_ptr->low_hand = i;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Check for takeover attempt and payment for extra military */
 		if (takeover && hand_military > 0)
@@ -5346,7 +5589,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 			move_card(g, list[0], who, WHERE_SAVED);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s saves 1 card under Galactic Scavengers.\n",
@@ -5617,7 +5860,7 @@ static void pay_settle(game *g, int who, int world, int mil_only, int mil_bonus)
 		p_ptr->military_spent += cost;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s conquers %s.\n", p_ptr->name,
@@ -5755,7 +5998,7 @@ int takeover_callback(game *g, int special, int world)
 			spend_prestige(g, c_ptr->owner, 1);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s spends 1 prestige on %s.\n",
@@ -5822,7 +6065,7 @@ int settle_check_takeover(game *g, int who, card *extra, int no_ask)
 	if (g->simulation && g->sim_who != who) return 0;
 
 	/* Don't ask if takeovers disabled */
-	if (g->takeover_disabled) return 0;
+	if (!HAS_TAKEOVERS(g) || g->takeover_disabled) return 0;
 
 	/* Get player pointer */
 	p_ptr = &g->p[who];
@@ -5955,7 +6198,7 @@ int settle_check_takeover(game *g, int who, card *extra, int no_ask)
 			c_ptr = &g->deck[x];
 
 			/* Skip just-played cards */
-			if (c_ptr->start_where != WHERE_ACTIVE) continue;
+			if (card_start_where(g, x) != WHERE_ACTIVE) continue;
 
 			/* Skip developments */
 			if (c_ptr->d_ptr->type != TYPE_WORLD) continue;
@@ -6005,7 +6248,7 @@ int settle_check_takeover(game *g, int who, card *extra, int no_ask)
 	c_ptr = &g->deck[special[0]];
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Check for card used for extra placement */
 		if (extra)
@@ -6096,7 +6339,7 @@ int upgrade_chosen(game *g, int who, int replacement, int old)
 	if (!upgrade_legal(g, replacement, old)) return 0;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s uses Terraforming Engineers to replace %s with %s.\n",
@@ -6192,7 +6435,7 @@ static int upgrade_available(game *g, int who)
 			b_ptr = &g->deck[y];
 
 			/* Skip newly-placed worlds */
-			if (b_ptr->start_where != WHERE_ACTIVE) continue;
+			if (card_start_where(g, y) != WHERE_ACTIVE) continue;
 
 			/* Skip non-worlds */
 			if (b_ptr->d_ptr->type != TYPE_WORLD) continue;
@@ -6252,7 +6495,7 @@ static int upgrade_world(game *g, int who)
 			b_ptr = &g->deck[y];
 
 			/* Skip newly-placed worlds */
-			if (b_ptr->start_where != WHERE_ACTIVE) continue;
+			if (card_start_where(g, y) != WHERE_ACTIVE) continue;
 
 			/* Skip non-worlds */
 			if (b_ptr->d_ptr->type != TYPE_WORLD) continue;
@@ -6427,7 +6670,7 @@ static void settle_bonus(game *g, int who, int world, int takeover,
 		player_discard(g, who, explore);
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s discards %d card%s.\n", g->p[who].name,
@@ -6475,7 +6718,7 @@ static void flip_world(game *g, int who)
 	c_ptr = &g->deck[which];
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s flips %s.\n", p_ptr->name, c_ptr->d_ptr->name);
@@ -6501,7 +6744,7 @@ static void flip_world(game *g, int who)
 		if (g->game_over) return;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s places %s at zero cost.\n", p_ptr->name,
@@ -6524,7 +6767,7 @@ static void flip_world(game *g, int who)
 		c_ptr->misc |= 1 << who;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s takes %s into hand.\n", p_ptr->name,
@@ -6600,7 +6843,7 @@ void settle_finish(game *g, int who, int world, int mil_only, int special,
 			g->deck[world].misc &= ~MISC_UNPAID;
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s places %s at zero cost.\n",
@@ -6632,7 +6875,7 @@ void settle_finish(game *g, int who, int world, int mil_only, int special,
 		move_card(g, special, -1, WHERE_DISCARD);
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s discards %s.\n", p_ptr->name,
@@ -6782,7 +7025,7 @@ void settle_chosen(game *g, int who, int first, int c_idx, int o_idx)
 		if (p_ptr->placing != -1)
 		{
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Get card used to place world */
 				c_ptr = &g->deck[c_idx];
@@ -6866,7 +7109,7 @@ void settle_chosen(game *g, int who, int first, int c_idx, int o_idx)
 		if (p_ptr->placing != -1)
 		{
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Get card used to place world */
 				c_ptr = &g->deck[c_idx];
@@ -6951,7 +7194,7 @@ void settle_chosen(game *g, int who, int first, int c_idx, int o_idx)
 			place_card(g, who, p_ptr->placing);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Get card used to place world */
 				c_ptr = &g->deck[c_idx];
@@ -7290,7 +7533,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 				move_card(g, special[i], -1, WHERE_DISCARD);
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards %s for extra military.\n",
@@ -7347,7 +7590,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 				p_ptr->bonus_military += o_ptr->value;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s discards a Rare good for "
@@ -7374,7 +7617,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 				p_ptr->bonus_military += o_ptr->value;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s spends prestige for "
@@ -7399,7 +7642,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 	military += num;
 
 	/* Message */
-	if (!g->simulation && num > 0)
+	if (GAME_MESSAGES(g) && num > 0)
 	{
 		/* Private message */
 		if (g->p[who].control->private_message)
@@ -7527,10 +7770,10 @@ static void defend_takeover(game *g, int who, int world, int attacker,
 	amt = p_ptr->hand_military_spent;
 
 	/* Start at first active card */
-	x = p_ptr->start_head[WHERE_ACTIVE];
+	x = start_list_head(g, who, WHERE_ACTIVE);
 
 	/* Loop over active cards (as of start of phase) */
-	for ( ; x != -1; x = g->deck[x].start_next)
+	for ( ; x != -1; x = start_list_next(g, who, WHERE_ACTIVE, x))
 	{
 		/* Get card pointer */
 		c_ptr = &g->deck[x];
@@ -7762,14 +8005,14 @@ int resolve_takeover(game *g, int who, int world, int special,
 	c_ptr = &g->deck[world];
 
 	/* Check for card moved since takeover declared */
-	if (c_ptr->where != c_ptr->start_where ||
-	    c_ptr->owner != c_ptr->start_owner)
+	if (c_ptr->where != card_start_where(g, world) ||
+	    c_ptr->owner != card_start_owner(g, world))
 	{
 		/* Takeover fails */
 		defeated = 1;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "Takeover of %s is defeated because the world has been moved.\n",
@@ -7787,7 +8030,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 	if (!defeated) attack = strength_against(g, who, world, special, 0);
 
 	/* Message */
-	if (!g->simulation && !defeated)
+	if (GAME_MESSAGES(g) && !defeated)
 	{
 		/* Format attack message */
 		sprintf(msg, "%s attacks %s with %d military.\n",
@@ -7832,7 +8075,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 	}
 
 	/* Message */
-	if (!g->simulation && !defeated)
+	if (GAME_MESSAGES(g) && !defeated)
 	{
 		/* Format defense message */
 		sprintf(msg, "%s defends %s with %d military.\n",
@@ -7848,7 +8091,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 	if (defeated || attack < defense)
 	{
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s fails to takeover %s.\n", p_ptr->name,
@@ -7866,7 +8109,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 	if (o_ptr->code & P3_DESTROY)
 	{
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s destroys %s.\n", p_ptr->name,
@@ -7907,7 +8150,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 		if (c_ptr->num_goods)
 		{
 			/* Start at player's first good */
-			x = g->p[c_ptr->start_owner].head[WHERE_GOOD];
+			x = g->p[card_start_owner(g, world)].head[WHERE_GOOD];
 
 			/* Loop over goods */
 			for ( ; x != -1; x = g->deck[x].next)
@@ -7934,7 +8177,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 	c_ptr->order = p_ptr->table_order++;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s takes over %s.\n", p_ptr->name,
@@ -7948,7 +8191,7 @@ int resolve_takeover(game *g, int who, int world, int special,
 	if (c_ptr->num_goods)
 	{
 		/* Start at player's first good */
-		x = g->p[c_ptr->start_owner].head[WHERE_GOOD];
+		x = g->p[card_start_owner(g, world)].head[WHERE_GOOD];
 
 		/* Loop over goods */
 		for ( ; x != -1; x = g->deck[x].next)
@@ -8072,7 +8315,7 @@ void resolve_takeovers(game *g)
 			}
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s spends prestige to defeat "
@@ -8105,7 +8348,7 @@ void resolve_takeovers(game *g)
 					g->takeover_defeated[j] = 1;
 
 					/* Message */
-					if (!g->simulation)
+					if (GAME_MESSAGES(g))
 					{
 						/* Format message */
 						sprintf(msg, "Takeover of %s is defeated because "
@@ -8244,7 +8487,7 @@ void phase_settle(game *g)
 		if (!asked[i])
 		{
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s does not place a world.\n",
@@ -8272,7 +8515,7 @@ void phase_settle(game *g)
 		if (p_ptr->placing == -1)
 		{
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s does not place a world.\n",
@@ -8288,7 +8531,7 @@ void phase_settle(game *g)
 		}
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s places %s.\n", p_ptr->name,
@@ -8311,8 +8554,8 @@ void phase_settle(game *g)
 		/* Get player pointer */
 		p_ptr = &g->p[i];
 
-		/* Check for prepare function */
-		if (p_ptr->control->prepare_phase)
+		/* Check for prepare function (unless answers are logged) */
+		if (p_ptr->control->prepare_phase && !fast_forwarding(g, i))
 		{
 			/* Ask player to prepare answers for payment */
 			p_ptr->control->prepare_phase(g, i, PHASE_SETTLE,
@@ -8559,7 +8802,7 @@ void trade_chosen(game *g, int who, int which, int no_bonus)
 		g->oort_kind = type;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s changes Alien Oort Cloud Refinery's "
@@ -8580,7 +8823,7 @@ void trade_chosen(game *g, int who, int which, int no_bonus)
 	value = trade_value(g, who, c_ptr, type, no_bonus);
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s trades good from %s for %d.\n", p_ptr->name,
@@ -9000,7 +9243,7 @@ int good_chosen(game *g, int who, int c_idx, int o_idx,
 		c_ptr->num_goods--;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s consumes good from %s using %s.\n",
@@ -9067,7 +9310,7 @@ int good_chosen(game *g, int who, int c_idx, int o_idx,
 	}
 
 	/* Check for simulated game */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Log rewards */
 		log_rewards(g, who, cards, vps, prestige, "from", name, FORMAT_VERBOSE);
@@ -9146,7 +9389,7 @@ static void draw_lucky(game *g, int who)
 	c_ptr = &g->deck[which];
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s guesses %d.\n", p_ptr->name, cost);
@@ -9177,7 +9420,7 @@ static void draw_lucky(game *g, int who)
 		c_ptr->misc |= 1 << who;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s keeps %s.\n", p_ptr->name,
@@ -9196,7 +9439,7 @@ static void draw_lucky(game *g, int who)
 		c_ptr->misc |= MISC_KNOWN_MASK;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s discards %s.\n", p_ptr->name,
@@ -9263,7 +9506,7 @@ static void ante_card(game *g, int who)
 	cost = c_ptr->d_ptr->cost;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s antes %s.\n", p_ptr->name, c_ptr->d_ptr->name);
@@ -9297,7 +9540,7 @@ static void ante_card(game *g, int who)
 		if (g->deck[drawn[i]].d_ptr->cost > cost) success = 1;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s draws %s.\n", p_ptr->name,
@@ -9351,7 +9594,7 @@ static void ante_card(game *g, int who)
 	if (g->game_over) return;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s keeps %s.\n", p_ptr->name,
@@ -9440,7 +9683,7 @@ int consume_hand_chosen(game *g, int who, int c_idx, int o_idx,
 	}
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Private message */
 		if (g->p[who].control->private_message)
@@ -9496,7 +9739,7 @@ int consume_hand_chosen(game *g, int who, int c_idx, int o_idx,
 	}
 
 	/* Check for simulated game */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Log rewards */
 		log_rewards(g, who, cards, vps, prestige,
@@ -9586,7 +9829,7 @@ void consume_prestige_chosen(game *g, int who, int c_idx, int o_idx)
 	o_ptr = &c_ptr->d_ptr->powers[o_idx];
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s consumes prestige using %s.\n",
@@ -9634,7 +9877,7 @@ void consume_prestige_chosen(game *g, int who, int c_idx, int o_idx)
 	}
 
 	/* Check for simulated game */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Log rewards */
 		log_rewards(g, who, cards, vps, 0,
@@ -10249,8 +10492,8 @@ void phase_consume(game *g)
 		/* Get player pointer */
 		p_ptr = &g->p[i];
 
-		/* Check for prepare function */
-		if (p_ptr->control->prepare_phase)
+		/* Check for prepare function (unless answers are logged) */
+		if (p_ptr->control->prepare_phase && !fast_forwarding(g, i))
 		{
 			/* Ask player to prepare answers for consume phase */
 			p_ptr->control->prepare_phase(g, i, PHASE_CONSUME, 0);
@@ -10267,8 +10510,8 @@ void phase_consume(game *g)
 		if (g->game_over) return;
 	}
 
-	/* Check for simulation */
-	if (!g->simulation)
+	/* Check for game messages wanted */
+	if (GAME_MESSAGES(g))
 	{
 		/* Loop over players */
 		for (i = 0; i < g->num_players; i++)
@@ -10320,7 +10563,7 @@ void produce_world(game *g, int who, int which, int c_idx, int o_idx)
 	c_ptr = &g->deck[which];
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "%s produces on %s.\n", p_ptr->name,
@@ -10380,7 +10623,7 @@ void produce_world(game *g, int who, int which, int c_idx, int o_idx)
 			g->oort_kind = kind;
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s changes Alien Oort Cloud Refinery's "
@@ -10975,7 +11218,7 @@ void produce_chosen(game *g, int who, int c_idx, int o_idx)
 		}
 
 		/* Message */
-		if (count > 0 && !g->simulation)
+		if (count > 0 && GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s takes %d card%s from under %s.\n",
@@ -11481,7 +11724,7 @@ void phase_produce_start(game *g)
 				c_ptr->covering = w_list[j].c_idx;
 
 				/* Check for simulated game */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s shifts good from %s to %s.\n",
@@ -11695,8 +11938,8 @@ void phase_produce(game *g)
 		/* Get player pointer */
 		p_ptr = &g->p[i];
 
-		/* Check for prepare function */
-		if (p_ptr->control->prepare_phase)
+		/* Check for prepare function (unless answers are logged) */
+		if (p_ptr->control->prepare_phase && !fast_forwarding(g, i))
 		{
 			/* Ask player to prepare answers for produce phase */
 			p_ptr->control->prepare_phase(g, i, PHASE_PRODUCE, 0);
@@ -11716,8 +11959,8 @@ void phase_produce(game *g)
 	/* Handle end of phase powers */
 	phase_produce_end(g);
 
-	/* Check for simulation */
-	if (!g->simulation)
+	/* Check for game messages wanted */
+	if (GAME_MESSAGES(g))
 	{
 		/* Loop over players */
 		for (i = 0; i < g->num_players; i++)
@@ -11816,7 +12059,7 @@ void phase_discard(game *g)
 		p_ptr->end_discard = n - target;
 
 		/* Message */
-		if (!g->simulation && !message)
+		if (GAME_MESSAGES(g) && !message)
 		{
 			/* Send formatted message */
 			message_add_formatted(g, "--- End of round ---\n", FORMAT_PHASE);
@@ -11862,7 +12105,7 @@ void phase_discard(game *g)
 		discard_callback(g, i, list, n);
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s discards %d card%s at end of round.\n",
@@ -11900,6 +12143,9 @@ void phase_discard(game *g)
 			/* Look for cards discarded by opponents */
 			for (j = 0; j < g->deck_size; j++)
 			{
+				/* Skip cards that did not move this phase */
+				if (!SET_HAS(g->moved_set, j)) continue;
+
 				/* Get card pointer */
 				c_ptr = &g->deck[j];
 
@@ -11940,7 +12186,7 @@ void phase_discard(game *g)
 			if (taken > 0)
 			{
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s takes %d discard%s.\n",
@@ -12468,6 +12714,9 @@ void check_goal_loss(game *g, int who, int goal)
 	int count, most = 0;
 	int i;
 
+	/* Check for no goals in this expansion */
+	if (!HAS_GOALS(g)) return;
+
 	/* Check for inactive goal */
 	if (!g->goal_active[goal]) return;
 
@@ -12505,7 +12754,7 @@ void check_goal_loss(game *g, int who, int goal)
 		g->goal_avail[goal] = 1;
 
 		/* Message */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s loses %s goal.\n", p_ptr->name,
@@ -12527,6 +12776,9 @@ void check_goals(game *g)
 	int i, j, k;
 	char msg[1024];
 
+	/* Check for no goals in this expansion */
+	if (!HAS_GOALS(g)) return;
+
 	/* Loop over "first" goals */
 	for (i = GOAL_FIRST_5_VP; i <= GOAL_FIRST_4_MILITARY; i++)
 	{
@@ -12622,7 +12874,7 @@ void check_goals(game *g)
 				g->goal_avail[i] = 0;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s claims %s goal.\n",
@@ -12717,7 +12969,7 @@ void check_goals(game *g)
 				p_ptr->goal_claimed[i] = 0;
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Format message */
 					sprintf(msg, "%s loses %s goal.\n",
@@ -12765,7 +13017,7 @@ void check_goals(game *g)
 				}
 
 				/* Message */
-				if (!g->simulation)
+				if (GAME_MESSAGES(g))
 				{
 					/* Get player pointer */
 					p_ptr = &g->p[j];
@@ -12794,6 +13046,7 @@ static void rotate_players(game *g)
 	card *c_ptr;
 	int i, bit, mask;
 	int camp_order[MAX_DECK], camp_size, camp_pos;
+	uint64_t owned[DECK_WORDS];
 
 	/* Store copy of player 0 */
 	temp = g->p[0];
@@ -12808,6 +13061,19 @@ static void rotate_players(game *g)
 	/* Store old player 0 in last spot */
 	g->p[i] = temp;
 
+	/* Store copy of player 0's card set */
+	memcpy(owned, g->owner_set[0], sizeof(owned));
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players - 1; i++)
+	{
+		/* Copy card sets one space */
+		memcpy(g->owner_set[i], g->owner_set[i + 1], sizeof(owned));
+	}
+
+	/* Store old player 0's cards in last spot */
+	memcpy(g->owner_set[i], owned, sizeof(owned));
+
 	/* Check for campaign */
 	if (g->camp)
 	{
@@ -12919,7 +13185,7 @@ int start_callback(game *g, int who, int list[], int n, int special[], int ns)
 	if (n != 2) return 0;
 
 	/* Message */
-	if (!g->simulation && p_ptr->control->private_message)
+	if (GAME_MESSAGES(g) && p_ptr->control->private_message)
 	{
 		/* Format message */
 		sprintf(msg, "%s discards the start world %s.\n",
@@ -13037,7 +13303,7 @@ void start_chosen(game *g)
 			move_card(g, hand[0], i, WHERE_SAVED);
 
 			/* Message */
-			if (!g->simulation)
+			if (GAME_MESSAGES(g))
 			{
 				/* Format message */
 				sprintf(msg, "%s saves 1 card under Galactic Scavengers.\n",
@@ -13104,7 +13370,7 @@ static void game_information(game *g)
 	message_add(g, msg);
 
 	/* Check for expansion with goals */
-	if (exp_info[g->expanded].has_goals)
+	if (HAS_GOALS(g))
 	{
 		/* Check for disabled goals */
 		if (g->goal_disabled)
@@ -13120,7 +13386,7 @@ static void game_information(game *g)
 	}
 
 	/* Check for expansion with takeovers */
-	if (exp_info[g->expanded].has_takeovers)
+	if (HAS_TAKEOVERS(g))
 	{
 		/* Check for disabled takeovers */
 		if (g->takeover_disabled)
@@ -13152,13 +13418,16 @@ void begin_game(game *g)
 	char msg[1024];
 
 	/* Send game information */
-	game_information(g);
+	if (GAME_MESSAGES(g)) game_information(g);
 
 	/* Start game */
 	g->cur_action = ACT_GAME_START;
 
 	/* Send start of game message */
-	message_add_formatted(g, "=== Start of game ===\n", FORMAT_EM);
+	if (GAME_MESSAGES(g))
+	{
+		message_add_formatted(g, "=== Start of game ===\n", FORMAT_EM);
+	}
 
 	/* Loop over cards in deck */
 	for (i = 0; i < g->deck_size; i++)
@@ -13430,7 +13699,7 @@ void begin_game(game *g)
 	}
 
 	/* Loop over players */
-	for (i = 0; i < g->num_players; i++)
+	for (i = 0; GAME_MESSAGES(g) && i < g->num_players; i++)
 	{
 		/* Get player pointer */
 		p_ptr = &g->p[i];
@@ -13456,11 +13725,15 @@ void begin_game(game *g)
 	/* Rotate players until player 0 holds lowest start world */
 	for (i = 0; i < low_i; i++) rotate_players(g);
 
-	/* Format message */
-	sprintf(msg, "%s is the first player.\n", g->p[0].name);
+	/* Check for game messages wanted */
+	if (GAME_MESSAGES(g))
+	{
+		/* Format message */
+		sprintf(msg, "%s is the first player.\n", g->p[0].name);
 
-	/* Send message */
-	message_add_formatted(g, msg, FORMAT_VERBOSE);
+		/* Send message */
+		message_add_formatted(g, msg, FORMAT_VERBOSE);
+	}
 
 	/* Check for "draw extra" campaign flag */
 	if (g->camp && (g->camp->flags & CAMP_DRAW_EXTRA))
@@ -13641,7 +13914,7 @@ int game_round(game *g)
 	if (g->game_over) return 0;
 
 	/* Message */
-	if (!g->simulation)
+	if (GAME_MESSAGES(g))
 	{
 		/* Format message */
 		sprintf(msg, "=== Round %d begins ===\n", g->round);
@@ -13699,7 +13972,7 @@ int game_round(game *g)
 		               NULL, NULL);
 
 		/* Check for real game */
-		if (!g->simulation && (!g->advanced || last))
+		if (GAME_MESSAGES(g) && (!g->advanced || last))
 		{
 			/* Format message */
 			sprintf(msg, "%s chooses %s.\n", p_ptr->name,
@@ -13718,7 +13991,7 @@ int game_round(game *g)
 		}
 
 		/* Check for real advanced game */
-		else if (!g->simulation)
+		else if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s chooses %s/%s.\n", p_ptr->name,
@@ -13772,7 +14045,7 @@ int game_round(game *g)
 		if (!count_active_flags(g, i, FLAG_SELECT_LAST)) continue;
 
 		/* Check for real game */
-		if (!g->simulation && !g->advanced)
+		if (GAME_MESSAGES(g) && !g->advanced)
 		{
 			/* Format message */
 			sprintf(msg, "%s chooses %s.\n", p_ptr->name,
@@ -13791,7 +14064,7 @@ int game_round(game *g)
 		}
 
 		/* Check for real game */
-		if (!g->simulation && g->advanced)
+		if (GAME_MESSAGES(g) && g->advanced)
 		{
 			/* Format message */
 			sprintf(msg, "%s chooses %s/%s.\n", p_ptr->name,
@@ -13828,7 +14101,7 @@ int game_round(game *g)
 		check_debug_rotate(g);
 
 		/* Check for real game */
-		if (!g->simulation)
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "--- %s phase ---\n", plain_actname[i]);
@@ -14541,7 +14814,7 @@ void score_game(game *g)
 			for (j = GOOD_NOVELTY; j <= GOOD_ALIEN; j++)
 			{
 				/* Simulate game */
-				sim = *g;
+				copy_game(&sim, g);
 
 				/* Mark game as simulation */
 				sim.simulation = 1;
@@ -14590,8 +14863,8 @@ void declare_winner(game *g)
 	int i, oort_owner = -1, th, tg, b_s = -1, b_t = -1, num_b_s = 0;
 	char msg[1024];
 
-	/* Check for simulation */
-	if (!g->simulation)
+	/* Check for game messages wanted */
+	if (GAME_MESSAGES(g))
 	{
 		/* Send end of game message */
 		message_add_formatted(g, "=== End of game ===\n", FORMAT_EM);
@@ -14626,7 +14899,7 @@ void declare_winner(game *g)
 		if (p_ptr->end_vp > b_s) b_s = p_ptr->end_vp;
 
 		/* Check for real game and owner of "any" good type */
-		if (!g->simulation && i == oort_owner)
+		if (GAME_MESSAGES(g) && i == oort_owner)
 		{
 			/* Format message */
 			sprintf(msg, "%s changes Alien Oort Cloud Refinery's "
@@ -14664,8 +14937,8 @@ void declare_winner(game *g)
 		/* Get player pointer */
 		p_ptr = &g->p[i];
 
-		/* Check for simulation */
-		if (!g->simulation)
+		/* Check for game messages wanted */
+		if (GAME_MESSAGES(g))
 		{
 			/* Format message */
 			sprintf(msg, "%s ends with %d VP%s.\n", g->p[i].name,
@@ -14684,8 +14957,8 @@ void declare_winner(game *g)
 		/* Get tiebreaker (goods) */
 		tg = count_player_area(g, i, WHERE_GOOD);
 
-		/* Check for simulation */
-		if (!g->simulation && num_b_s > 1)
+		/* Check for game messages wanted */
+		if (GAME_MESSAGES(g) && num_b_s > 1)
 		{
 			/* Format message */
 			sprintf(msg, "%s has %d card%s in hand and %d good%s "
@@ -14703,8 +14976,8 @@ void declare_winner(game *g)
 		p_ptr->winner = 1;
 	}
 
-	/* Check for simulation */
-	if (!g->simulation)
+	/* Check for game messages wanted */
+	if (GAME_MESSAGES(g))
 	{
 		/* Loop over players */
 		for (i = 0; i < g->num_players; i++)
@@ -101,6 +101,44 @@ static int *orig_log[MAX_PLAYER];
  */
 static int orig_log_size[MAX_PLAYER];
 
+/*
+ * Number of round-start snapshots kept for undo/redo.
+ */
+#define MAX_SNAPSHOT 32
+
+/*
+ * Game state saved at the start of a round, used to avoid replaying
+ * the entire game from the beginning on undo/redo.
+ */
+typedef struct snapshot
+{
+	/* Game state before the round begins */
+	game g;
+
+	/* Campaign status before the round begins */
+	campaign_status camp_status;
+
+	/* Number of human player choices consumed before this round */
+	int num_choice;
+
+	/* Serialized contents of the message log */
+	guint8 *log_data;
+
+	/* Length of serialized message log */
+	gsize log_len;
+
+} snapshot;
+
+/*
+ * Saved snapshots (unordered).
+ */
+static snapshot *snapshots[MAX_SNAPSHOT];
+
+/*
+ * Number of snapshots saved.
+ */
+static int num_snapshot;
+
 /*
  * Games started (used for random sampling)
  */
@@ -5359,7 +5397,7 @@ static void compute_military(game *g, int who, mil_strength *m_ptr)
 	m_ptr->bonus_xeno = g->p[who].bonus_military_xeno;
 
 	/* Get first active card */
-	x = g->p[who].start_head[WHERE_ACTIVE];
+	x = start_list_head(g, who, WHERE_ACTIVE);
 
 	/* Count number of novelty goods */
 	novelty_goods = count_goods(g, who, GOOD_NOVELTY);
@@ -5371,7 +5409,7 @@ static void compute_military(game *g, int who, mil_strength *m_ptr)
 	alien_goods = count_goods(g, who, GOOD_ALIEN);
 
 	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].start_next)
+	for ( ; x != -1; x = start_list_next(g, who, WHERE_ACTIVE, x))
 	{
 		/* Get card pointer */
 		c_ptr = &g->deck[x];
@@ -6709,8 +6747,8 @@ void gui_choose_discard(game *g, int who, int list[], int *num, int discard)
 				i_ptr->push = 1;
 
 				/* Check for new card */
-				if (c_ptr->start_where != WHERE_HAND ||
-				    c_ptr->start_owner != who)
+				if (card_start_where(g, list[i]) != WHERE_HAND ||
+				    card_start_owner(g, list[i]) != who)
 				{
 					/* Put gap before card */
 					i_ptr->gapped = 1;
@@ -9976,6 +10014,251 @@ static int load_auto_save(game *g)
 	return TRUE;
 }
 
+/*
+ * Forget all saved snapshots.
+ */
+static void clear_snapshots(void)
+{
+	int i;
+
+	/* Loop over saved snapshots */
+	for (i = 0; i < num_snapshot; i++)
+	{
+		/* Free saved message log */
+		g_free(snapshots[i]->log_data);
+
+		/* Free snapshot */
+		free(snapshots[i]);
+	}
+
+	/* No snapshots remain */
+	num_snapshot = 0;
+}
+
+/*
+ * Forget snapshots which depend on human choices beyond the given count.
+ */
+static void drop_snapshots(int num_choice)
+{
+	snapshot *s_ptr;
+	int i = 0;
+
+	/* Loop over saved snapshots */
+	while (i < num_snapshot)
+	{
+		/* Get snapshot pointer */
+		s_ptr = snapshots[i];
+
+		/* Keep snapshots from before the given choice */
+		if (s_ptr->num_choice <= num_choice)
+		{
+			/* Advance to next snapshot */
+			i++;
+			continue;
+		}
+
+		/* Free saved message log */
+		g_free(s_ptr->log_data);
+
+		/* Free snapshot */
+		free(s_ptr);
+
+		/* Move last snapshot into freed slot */
+		snapshots[i] = snapshots[--num_snapshot];
+	}
+}
+
+/*
+ * Save the game state at the start of a round.
+ */
+static void save_snapshot(game *g)
+{
+	static GdkAtom format;
+	GtkTextBuffer *message_buffer;
+	GtkTextIter start_iter, end_iter;
+	snapshot *s_ptr;
+	int i, pos, choice, oldest = -1;
+
+	/* Loop over saved snapshots */
+	for (i = 0; i < num_snapshot; i++)
+	{
+		/* Check for this round already saved */
+		if (snapshots[i]->g.round == g->round) return;
+
+		/* Remember snapshot of earliest round */
+		if (oldest < 0 ||
+		    snapshots[i]->g.round < snapshots[oldest]->g.round)
+		{
+			/* Track earliest snapshot */
+			oldest = i;
+		}
+	}
+
+	/* Reset counts */
+	pos = choice = 0;
+
+	/* Count human choices consumed so far */
+	while (pos < g->p[0].choice_pos)
+	{
+		/* Update log position */
+		pos = next_choice(g->p[0].choice_log, pos);
+
+		/* Add one to choice count */
+		++choice;
+	}
+
+	/* Check for room for another snapshot */
+	if (num_snapshot < MAX_SNAPSHOT)
+	{
+		/* Allocate new snapshot */
+		s_ptr = (snapshot *)malloc(sizeof(snapshot));
+
+		/* Add to list */
+		snapshots[num_snapshot++] = s_ptr;
+	}
+	else
+	{
+		/* Reuse snapshot of earliest round */
+		s_ptr = snapshots[oldest];
+
+		/* Free previous message log */
+		g_free(s_ptr->log_data);
+	}
+
+	/* Copy game state */
+	copy_game(&s_ptr->g, g);
+
+	/* Check for campaign game */
+	if (g->camp)
+	{
+		/* Copy campaign status, which copy_game() only points to */
+		memcpy(&s_ptr->camp_status, g->camp_status,
+		       sizeof(campaign_status));
+	}
+
+	/* Remember human choices consumed */
+	s_ptr->num_choice = choice;
+
+	/* Get message buffer */
+	message_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(message_view));
+
+	/* Register internal serialization format on first use */
+	if (!format)
+		format = gtk_text_buffer_register_serialize_tagset(message_buffer,
+		                                                   NULL);
+
+	/* Get bounds of message buffer */
+	gtk_text_buffer_get_bounds(message_buffer, &start_iter, &end_iter);
+
+	/* Save message log with formatting */
+	s_ptr->log_data = gtk_text_buffer_serialize(message_buffer,
+	                                            message_buffer, format,
+	                                            &start_iter, &end_iter,
+	                                            &s_ptr->log_len);
+}
+
+/*
+ * Restore the latest snapshot at or before the current undo position.
+ *
+ * Returns FALSE if no usable snapshot exists and the game must be
+ * replayed from the beginning.
+ */
+static int restore_snapshot(game *g)
+{
+	static GdkAtom format;
+	GtkTextBuffer *message_buffer;
+	GtkTextIter end_iter;
+	snapshot *s_ptr = NULL;
+	campaign_status *camp_status;
+	char *human_name, *name[MAX_PLAYER];
+	int choice_size[MAX_PLAYER];
+	int i;
+
+	/* Loop over saved snapshots */
+	for (i = 0; i < num_snapshot; i++)
+	{
+		/* Skip snapshots past the undo position */
+		if (snapshots[i]->num_choice > num_undo) continue;
+
+		/* Remember snapshot of latest round */
+		if (!s_ptr || snapshots[i]->g.round > s_ptr->g.round)
+		{
+			/* Track latest snapshot */
+			s_ptr = snapshots[i];
+		}
+	}
+
+	/* Check for no usable snapshot */
+	if (!s_ptr) return FALSE;
+
+	/* Get message buffer */
+	message_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(message_view));
+
+	/* Register internal serialization format on first use */
+	if (!format)
+		format = gtk_text_buffer_register_deserialize_tagset(message_buffer,
+		                                                     NULL);
+
+	/* Get end of (cleared) message buffer */
+	gtk_text_buffer_get_end_iter(message_buffer, &end_iter);
+
+	/* Restore message log */
+	if (!gtk_text_buffer_deserialize(message_buffer, message_buffer, format,
+	                                 &end_iter, s_ptr->log_data,
+	                                 s_ptr->log_len, NULL))
+	{
+		/* Clear partially restored log */
+		clear_log();
+
+		/* Replay from beginning instead */
+		return FALSE;
+	}
+
+	/* Move end mark to end of restored log */
+	gtk_text_buffer_get_end_iter(message_buffer, &end_iter);
+	gtk_text_buffer_move_mark(message_buffer, message_end, &end_iter);
+
+	/* Remember human player name and campaign status */
+	human_name = g->human_name;
+	camp_status = g->camp_status;
+
+	/* Loop over players */
+	for (i = 0; i < MAX_PLAYER; i++)
+	{
+		/* Remember name and log size set for this replay */
+		name[i] = g->p[i].name;
+		choice_size[i] = g->p[i].choice_size;
+	}
+
+	/* Copy saved game state */
+	copy_game(g, &s_ptr->g);
+
+	/* Restore human player name */
+	g->human_name = human_name;
+
+	/* Restore campaign status pointer */
+	g->camp_status = camp_status;
+
+	/* Check for campaign game */
+	if (g->camp)
+	{
+		/* Restore campaign draw positions */
+		memcpy(g->camp_status, &s_ptr->camp_status,
+		       sizeof(campaign_status));
+	}
+
+	/* Loop over players */
+	for (i = 0; i < MAX_PLAYER; i++)
+	{
+		/* Restore name and log size */
+		g->p[i].name = name[i];
+		g->p[i].choice_size = choice_size[i];
+	}
+
+	/* Success */
+	return TRUE;
+}
+
 /*
  * Should be called when a choice is done, in order to update undo information.
  */
@@ -10001,6 +10284,9 @@ static void choice_done(game *g)
 	/* Stop game replaying */
 	game_replaying = FALSE;
 
+	/* Forget snapshots made after this choice in the old log */
+	drop_snapshots(num_undo);
+
 	/* Add one to undo position */
 	++num_undo;
 
@@ -10311,6 +10597,348 @@ decisions gui_func =
 	message_add_private,
 };
 
+/*
+ * AI decision being computed in a background thread.
+ */
+typedef struct ai_request
+{
+	/* Game the answer belongs to */
+	game *real;
+
+	/* Private copy of game for the AI to examine */
+	game g;
+
+	/* Player making the decision */
+	int who;
+
+	/* Private choice logs, so the AI never writes to the real ones */
+	int log[MAX_PLAYER][4096];
+
+	/* Size of deciding player's log before the decision */
+	int old_size;
+
+	/* Choice type and arguments */
+	int type, arg1, arg2, arg3;
+
+	/* Copies of choice lists */
+	int list[MAX_DECK], nl;
+	int special[MAX_DECK], ns;
+
+	/* Whether special list was given */
+	int has_special;
+
+	/* Answer is ready */
+	volatile gint done;
+
+	/* Timeout source updating the wait prompt */
+	guint source;
+
+	/* Time spent thinking */
+	GTimer *timer;
+
+} ai_request;
+
+/*
+ * Current background AI decision.
+ */
+static ai_request ai_req;
+
+/*
+ * Thread computing background AI decision (if any).
+ */
+static GThread *ai_thread;
+
+/*
+ * Compute an AI decision in the background thread.
+ */
+static gpointer ai_thread_run(gpointer data)
+{
+	ai_request *r = (ai_request *)data;
+
+	/* Ask AI for answer */
+	ai_func.make_choice(&r->g, r->who, r->type, r->list, &r->nl,
+	                    r->has_special ? r->special : NULL,
+	                    r->has_special ? &r->ns : NULL,
+	                    r->arg1, r->arg2, r->arg3);
+
+	/* Mark answer ready */
+	g_atomic_int_set(&r->done, TRUE);
+
+	/* Done */
+	return NULL;
+}
+
+/*
+ * Append the AI's answer from the private log to the real one.
+ */
+static void ai_thread_answer(void)
+{
+	player *p_ptr = &ai_req.real->p[ai_req.who];
+	int size = ai_req.g.p[ai_req.who].choice_size;
+
+	/* Discard answer to an aborted game */
+	if (ai_req.real->game_over) return;
+
+	/* Copy new log entries */
+	memcpy(p_ptr->choice_log + ai_req.old_size,
+	       ai_req.log[ai_req.who] + ai_req.old_size,
+	       sizeof(int) * (size - ai_req.old_size));
+
+	/* Make answer visible */
+	p_ptr->choice_size = size;
+}
+
+/*
+ * Wait for the background thread to exit and copy its answer.
+ *
+ * This blocks without handling events.
+ */
+static void ai_thread_finish(void)
+{
+	/* Check for no background decision */
+	if (!ai_thread) return;
+
+	/* Wait for thread to exit */
+	g_thread_join(ai_thread);
+
+	/* Clear thread */
+	ai_thread = NULL;
+
+	/* Copy answer */
+	ai_thread_answer();
+}
+
+/*
+ * Update the wait prompt and check whether the background answer is ready.
+ */
+static gboolean ai_thread_check(gpointer data)
+{
+	char buf[1024];
+
+	/* Check for answer ready */
+	if (g_atomic_int_get(&ai_req.done))
+	{
+		/* Source will be removed */
+		ai_req.source = 0;
+
+		/* Quit waiting */
+		gtk_main_quit();
+
+		/* Remove timeout */
+		return FALSE;
+	}
+
+	/* Format prompt with time spent thinking */
+	sprintf(buf, "Waiting for %s (%.1f s)",
+	        ai_req.real->p[ai_req.who].name,
+	        g_timer_elapsed(ai_req.timer, NULL));
+
+	/* Set prompt */
+	gtk_label_set_text(GTK_LABEL(action_prompt), buf);
+
+	/* Keep checking */
+	return TRUE;
+}
+
+/*
+ * Wait for a background answer from the given player, handling events
+ * in the meantime.
+ *
+ * This is the same nested main loop gui_make_choice() runs while the
+ * human decides, so callbacks may run here exactly as they may there:
+ * those that change the game only set restart_loop and game_over and
+ * quit the loop.  The thread touches nothing but ai_req.g and its
+ * private logs, so redraws and saves may read the real game meanwhile.
+ */
+static void ai_thread_wait(game *g, int who)
+{
+	/* Check for no background decision for this player */
+	if (!ai_thread || ai_req.who != who) return;
+
+	/* Check for answer not yet ready */
+	if (!g_atomic_int_get(&ai_req.done))
+	{
+		/* Check answer (and update prompt) periodically */
+		ai_req.source = g_timeout_add(100, ai_thread_check, NULL);
+
+		/* Handle events until answer is ready */
+		gtk_main();
+
+		/* Remove timeout if loop was quit for another reason */
+		if (ai_req.source) g_source_remove(ai_req.source);
+
+		/* Clear source */
+		ai_req.source = 0;
+	}
+
+	/* Collect answer */
+	ai_thread_finish();
+}
+
+/*
+ * Finish any background decision, handling events in the meantime.
+ */
+static void ai_thread_sync(void)
+{
+	/* Wait for pending decision */
+	if (ai_thread) ai_thread_wait(ai_req.real, ai_req.who);
+}
+
+/*
+ * Start an AI decision in the background.
+ *
+ * The answer is collected by the engine calling ai_thread_wait() later,
+ * which keeps the interface responsive while the AI thinks.  Since the
+ * AI search state is shared, only one AI decision is computed at a time.
+ */
+static void ai_thread_make_choice(game *g, int who, int type, int list[],
+                                  int *nl, int special[], int *ns, int arg1,
+                                  int arg2, int arg3)
+{
+	int i;
+
+	/* Only one AI may think at once */
+	ai_thread_sync();
+
+	/* Check for aborted game */
+	if (g->game_over) return;
+
+	/* Copy game for AI to examine */
+	copy_game(&ai_req.g, g);
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Use private choice log */
+		ai_req.g.p[i].choice_log = ai_req.log[i];
+
+		/* Copy entries made so far */
+		memcpy(ai_req.log[i], g->p[i].choice_log,
+		       sizeof(int) * g->p[i].choice_size);
+	}
+
+	/* Remember where answer will start */
+	ai_req.old_size = g->p[who].choice_size;
+
+	/* Save request parameters */
+	ai_req.real = g;
+	ai_req.who = who;
+	ai_req.type = type;
+	ai_req.arg1 = arg1;
+	ai_req.arg2 = arg2;
+	ai_req.arg3 = arg3;
+
+	/* Copy choice list */
+	ai_req.nl = *nl;
+	memcpy(ai_req.list, list, sizeof(int) * *nl);
+
+	/* Check for special list */
+	ai_req.has_special = special != NULL;
+
+	/* Copy special list */
+	ai_req.ns = ns ? *ns : 0;
+	if (special) memcpy(ai_req.special, special, sizeof(int) * ai_req.ns);
+
+	/* Answer not ready */
+	ai_req.done = FALSE;
+
+	/* Create timer on first use */
+	if (!ai_req.timer) ai_req.timer = g_timer_new();
+
+	/* Start timing */
+	g_timer_start(ai_req.timer);
+
+	/* Start thread */
+	ai_thread = g_thread_create(ai_thread_run, &ai_req, TRUE, NULL);
+
+	/* Check for failure to create thread */
+	if (!ai_thread)
+	{
+		/* Think in this thread instead */
+		ai_thread_run(&ai_req);
+
+		/* Copy answer */
+		ai_thread_answer();
+	}
+}
+
+/*
+ * Initialize AI player.
+ */
+static void ai_thread_init(game *g, int who, double factor)
+{
+	/* Finish background decision */
+	ai_thread_finish();
+
+	/* Initialize AI */
+	ai_func.init(g, who, factor);
+}
+
+/*
+ * Player spots have been rotated.
+ */
+static void ai_thread_notify_rotation(game *g, int who)
+{
+	/* Finish background decision */
+	ai_thread_sync();
+
+	/* Notify AI */
+	ai_func.notify_rotation(g, who);
+}
+
+/*
+ * Take sample cards into hand from Explore phase.
+ */
+static void ai_thread_explore_sample(game *g, int who, int draw, int keep,
+                                     int discard_any)
+{
+	/* Finish background decision */
+	ai_thread_sync();
+
+	/* Let AI choose */
+	ai_func.explore_sample(g, who, draw, keep, discard_any);
+}
+
+/*
+ * Game over.
+ */
+static void ai_thread_game_over(game *g, int who)
+{
+	/* Finish background decision */
+	ai_thread_finish();
+
+	/* Notify AI */
+	ai_func.game_over(g, who);
+}
+
+/*
+ * Shutdown.
+ */
+static void ai_thread_shutdown(game *g, int who)
+{
+	/* Finish background decision */
+	ai_thread_finish();
+
+	/* Shut down AI */
+	ai_func.shutdown(g, who);
+}
+
+/*
+ * Interface to AI decision functions running in a background thread.
+ */
+static decisions ai_thread_func =
+{
+	ai_thread_init,
+	ai_thread_notify_rotation,
+	NULL,
+	ai_thread_make_choice,
+	ai_thread_wait,
+	ai_thread_explore_sample,
+	ai_thread_game_over,
+	ai_thread_shutdown,
+	NULL,
+};
+
 /*
  * Apply options to game structure.
  */
@@ -10406,6 +11034,9 @@ void reset_gui(void)
 {
 	int i;
 
+	/* Finish any background AI decision */
+	ai_thread_finish();
+
 	/* Reset our player index */
 	player_us = 0;
 
@@ -10455,8 +11086,8 @@ void reset_gui(void)
 	/* Loop over AI players */
 	for (i = 1; i < MAX_PLAYER; i++)
 	{
-		/* Set control to AI functions */
-		real_game.p[i].control = &ai_func;
+		/* Set control to AI functions thinking in the background */
+		real_game.p[i].control = &ai_thread_func;
 		real_game.p[i].ai = TRUE;
 
 		/* Call initialization function */
@@ -10584,6 +11215,9 @@ static void run_game(void)
 			num_undo = 0;
 			max_undo = 0;
 
+			/* Forget snapshots of previous game */
+			clear_snapshots();
+
 			/* Loop over players */
 			for (i = 0; i < real_game.num_players; i++)
 			{
@@ -10621,6 +11255,9 @@ static void run_game(void)
 		/* Holding pattern for multiplayer */
 		else if (restart_loop == RESTART_NONE)
 		{
+			/* Finish any background AI decision */
+			ai_thread_finish();
+
 			/* Notify gui */
 			update_menu_items();
 
@@ -10808,6 +11445,9 @@ static void run_game(void)
 			/* Set tampered loaded flag */
 			game_tampered = TAMPERED_LOAD;
 
+			/* Forget snapshots of previous game */
+			clear_snapshots();
+
 			/* Start with start of game random seed */
 			real_game.random_seed = real_game.start_seed;
 
@@ -10830,6 +11470,9 @@ static void run_game(void)
 			/* Set tampered loaded flag */
 			game_tampered = TAMPERED_LOAD;
 
+			/* Forget snapshots of previous game */
+			clear_snapshots();
+
 			/* Start with start of game random seed */
 			real_game.random_seed = real_game.start_seed;
 
@@ -10849,6 +11492,9 @@ static void run_game(void)
 			/* Reset our position and GUI elements */
 			reset_gui();
 
+			/* Log options or choices may have changed */
+			clear_snapshots();
+
 			/* Start with start of game random seed */
 			real_game.random_seed = real_game.start_seed;
 
@@ -10894,14 +11540,25 @@ static void run_game(void)
 		/* Game is run by gui */
 		real_game.session_id = -1;
 
-		/* Begin game */
-		begin_game(&real_game);
+		/* Resume from latest usable snapshot if possible */
+		if (!restore_snapshot(&real_game))
+		{
+			/* Begin game */
+			begin_game(&real_game);
 
-		/* Check for aborted game */
-		if (real_game.game_over) continue;
+			/* Check for aborted game */
+			if (real_game.game_over) continue;
+		}
 
 		/* Play game rounds until finished */
-		while (game_round(&real_game));
+		while (1)
+		{
+			/* Save state at start of round */
+			save_snapshot(&real_game);
+
+			/* Play round */
+			if (!game_round(&real_game)) break;
+		}
 
 		/* Check for restart request */
 		if (restart_loop)
@@ -13879,6 +14536,9 @@ static void debug_ai_dialog(GtkMenuItem *menu_item, gpointer data)
 	/* Set window title */
 	gtk_window_set_title(GTK_WINDOW(dialog), TITLE);
 
+	/* Finish background decision before examining AI state */
+	ai_thread_finish();
+
 	/* Get debug information from AI */
 	ai_debug(&real_game, win_prob, role, action_score, &num_action);
 
@@ -14255,6 +14915,9 @@ int main(int argc, char *argv[])
 	/* Prevent locale usage -- use C locale for everything */
 	gtk_disable_setlocale();
 
+	/* Initialize thread support for background AI */
+	if (!g_thread_supported()) g_thread_init(NULL);
+
 	/* Parse GTK options */
 	gtk_init(&argc, &argv);
 
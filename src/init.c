@@ -1094,6 +1094,9 @@ void init_game(game *g)
 	/* Game is not a debug game */
 	g->debug_game = 0;
 
+	/* Game is not fast-forwarding */
+	g->fast_forward = 0;
+
 	/* No rotation */
 	g->debug_rotate = 0;
 
@@ -1101,7 +1104,7 @@ void init_game(game *g)
 	g->vp_pool = g->num_players * 12;
 
 	/* Increase size of pool in third expansion */
-	if (exp_info[g->expanded].has_prestige) g->vp_pool += 5;
+	if (HAS_PRESTIGE(g)) g->vp_pool += 5;
 
 	/* No game round yet */
 	g->round = 0;
@@ -1135,6 +1138,13 @@ void init_game(game *g)
 	/* Set Oort Cloud kind to "any" */
 	g->oort_kind = GOOD_ANY;
 
+	/* No cards owned by anyone */
+	memset(g->owner_set, 0, sizeof(g->owner_set));
+	memset(g->where_set, 0, sizeof(g->where_set));
+
+	/* No cards have moved */
+	memset(g->moved_set, 0, sizeof(g->moved_set));
+
 	/* Loop over card designs */
 	for (i = 0; i < num_design; i++)
 	{
@@ -1179,8 +1189,8 @@ void init_game(game *g)
 			/* No goods on card */
 			c_ptr->num_goods = 0;
 
-			/* Card is not followed by any other */
-			c_ptr->next = c_ptr->start_next = -1;
+			/* Card is not linked to any other */
+			c_ptr->next = c_ptr->prev = c_ptr->start_next = -1;
 		}
 	}
 
@@ -1213,6 +1223,9 @@ void init_game(game *g)
 		/* Player has no card to be placed */
 		p_ptr->placing = -1;
 
+		/* Player has not chosen a start world */
+		p_ptr->start = -1;
+
 		/* Player has no cards in any area */
 		for (j = 0; j < MAX_WHERE; j++)
 		{
@@ -1221,6 +1234,9 @@ void init_game(game *g)
 			p_ptr->start_head[j] = -1;
 		}
 
+		/* No lists have changed */
+		p_ptr->start_saved = 0;
+
 		/* Player has no bonus military accrued */
 		p_ptr->bonus_military = 0;
 
@@ -1275,7 +1291,7 @@ void init_game(game *g)
 	}
 
 	/* Add goals when expanded */
-	if (exp_info[g->expanded].has_goals && !g->goal_disabled)
+	if (HAS_GOALS(g) && !g->goal_disabled)
 	{
 		/* No goals available yet */
 		n = 0;
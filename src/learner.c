@@ -70,8 +70,12 @@ int main(int argc, char *argv[])
 {
 	game my_game;
 	int i, j, n = 100;
-	int num_players = 3;
+	int num_players = 3, profile = 0;
+#ifdef FIXED_EXPANSION
+	int expansion = FIXED_EXPANSION, advanced = 0, promo = 0;
+#else
 	int expansion = 0, advanced = 0, promo = 0;
+#endif
 	char buf[1024], *names[MAX_PLAYER];
 	double factor = 1.0;
 
@@ -143,7 +147,25 @@ int main(int argc, char *argv[])
 			/* Set factor */
 			factor = atof(argv[++i]);
 		}
+
+		/* Check for AI profile request */
+		else if (!strcmp(argv[i], "-P"))
+		{
+			/* Print profile at end */
+			profile = 1;
+		}
+	}
+
+#ifdef FIXED_EXPANSION
+	/* Check for expansion not supported by this build */
+	if (expansion != FIXED_EXPANSION)
+	{
+		/* Error */
+		fprintf(stderr, "Learner built for expansion %d only\n",
+		        FIXED_EXPANSION);
+		exit(1);
 	}
+#endif
 
 	/* Set number of players */
 	my_game.num_players = num_players;
@@ -164,6 +186,9 @@ int main(int argc, char *argv[])
 	/* No campaign selected */
 	my_game.camp = NULL;
 
+	/* Do not generate messages unless they are printed */
+	my_game.silent = !verbose;
+
 	/* Call initialization functions */
 	for (i = 0; i < num_players; i++)
 	{
@@ -219,6 +244,9 @@ int main(int argc, char *argv[])
 		/* Declare winner */
 		declare_winner(&my_game);
 
+		/* Report AI heap allocations so far */
+		if (verbose > 1) printf("AI allocations: %ld\n", ai_num_alloc);
+
 		/* Call player game over functions */
 		for (j = 0; j < num_players; j++)
 		{
@@ -245,6 +273,9 @@ int main(int argc, char *argv[])
 		my_game.p[i].control->shutdown(&my_game, i);
 	}
 
+	/* Print AI profile if requested */
+	if (profile) ai_print_profile(stdout);
+
 	/* Done */
 	return 0;
 }
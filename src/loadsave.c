@@ -23,6 +23,12 @@
 
 #include "rftg.h"
 
+/*
+ * Header and format version of game archives (see archive_game below).
+ */
+#define ARCHIVE_MAGIC   "RFTGA\n"
+#define ARCHIVE_VERSION 1
+
 /*
  * Read a game from a file.
  */
@@ -132,8 +138,38 @@ static int read_game(game *g, FILE* fff)
 	return 0;
 }
 
+/*
+ * Load a game given as "archive:N", meaning game N of the archive.
+ */
+static int load_archive_name(game *g, char *filename)
+{
+	char name[1024], *sep;
+
+	/* Check for too long name */
+	if (strlen(filename) >= sizeof(name)) return -1;
+
+	/* Copy name */
+	strcpy(name, filename);
+
+	/* Find separator */
+	sep = strrchr(name, ':');
+
+	/* Check for no game number */
+	if (!sep || !sep[1] || strspn(sep + 1, "0123456789") != strlen(sep + 1))
+		return -1;
+
+	/* Split archive name from game number */
+	*sep = '\0';
+
+	/* Load game from archive */
+	return load_archive_game(g, name, atoi(sep + 1), NULL, NULL);
+}
+
 /*
  * Load a game from the given filename.
+ *
+ * A game archive can be given as "archive:N" to load game N of it
+ * instead of the first.
  */
 int load_game(game *g, char *filename)
 {
@@ -145,7 +181,7 @@ int load_game(game *g, char *filename)
 	fff = fopen(filename, "r");
 
 	/* Check for failure */
-	if (!fff) return -1;
+	if (!fff) return load_archive_name(g, filename);
 
 	/* Read header */
 	if (!fgets(buf, 1024, fff)) return -1;
@@ -178,6 +214,16 @@ int load_game(game *g, char *filename)
 		ret_val = 0;
 	}
 
+	/* Check for game archive */
+	else if (!strcmp(buf, ARCHIVE_MAGIC))
+	{
+		/* Close file */
+		fclose(fff);
+
+		/* Load first game in archive */
+		return load_archive_game(g, filename, 0, NULL, NULL);
+	}
+
 	/* Check for success */
 	if (ret_val == 0)
 	{
@@ -269,6 +315,738 @@ int save_game(game *g, char *filename, int player_us)
 	return 0;
 }
 
+/*
+ * Game archives.
+ *
+ * An archive holds any number of complete games in a compact binary
+ * form.  The file starts with ARCHIVE_MAGIC and a format version, and
+ * each game is stored as its length followed by the game record.  All
+ * numbers are stored as variable length integers (seven bits per byte,
+ * low bits first), with signed choice log entries zigzag encoded.
+ *
+ * Each choice in a log is its type, return value, list size, list,
+ * special list size and special list.  Each list and special list entry
+ * is stored as the difference from the entry before it in the same list.
+ *
+ * A game record holds:
+ *
+ *   start seed, number of players, expansion, advanced flag,
+ *   goals disabled flag, takeovers disabled flag,
+ *   campaign name, human player name (empty strings if none),
+ *   size of random byte pool (zero if none) and the pool itself,
+ *   then for each player the number of choice log entries and entries.
+ *
+ * Next to the archive, a file with ".idx" appended to the name holds the
+ * file offset of each game as eight bytes (low byte first), so that any
+ * game can be found without reading those before it.  The index is
+ * started over whenever the archive is created, and rebuilt from the
+ * archive before a game is added if it does not list every game.
+ */
+
+/*
+ * Size of players' choice logs.
+ */
+#define ARCHIVE_MAX_LOG 4096
+
+/*
+ * Add a variable length integer to a buffer.
+ */
+static void put_varint(unsigned char **ptr, unsigned int x)
+{
+	/* Loop until all bits written */
+	while (x >= 0x80)
+	{
+		/* Write low bits with continuation flag */
+		*(*ptr)++ = (x & 0x7f) | 0x80;
+
+		/* Move to next bits */
+		x >>= 7;
+	}
+
+	/* Write last bits */
+	*(*ptr)++ = x;
+}
+
+/*
+ * Read a variable length integer from a buffer.
+ */
+static int get_varint(unsigned char **ptr, unsigned char *end,
+                      unsigned int *x)
+{
+	int shift = 0;
+
+	/* Clear value */
+	*x = 0;
+
+	/* Loop over bytes */
+	while (*ptr < end && shift < 32)
+	{
+		/* Add low bits */
+		*x |= (unsigned int)(**ptr & 0x7f) << shift;
+
+		/* Check for last byte */
+		if (!(*(*ptr)++ & 0x80)) return 0;
+
+		/* Move to next bits */
+		shift += 7;
+	}
+
+	/* Truncated or malformed value */
+	return -1;
+}
+
+/*
+ * Add a string to a buffer.
+ */
+static void put_string(unsigned char **ptr, const char *s)
+{
+	int len = s ? strlen(s) : 0;
+
+	/* Write length */
+	put_varint(ptr, len);
+
+	/* Write characters */
+	if (len) memcpy(*ptr, s, len);
+	*ptr += len;
+}
+
+/*
+ * Read a string from a buffer.
+ */
+static int get_string(unsigned char **ptr, unsigned char *end, char *s,
+                      int size)
+{
+	unsigned int len;
+
+	/* Read length */
+	if (get_varint(ptr, end, &len) < 0) return -1;
+
+	/* Check for too long */
+	if (len >= size || len > end - *ptr) return -1;
+
+	/* Copy characters */
+	memcpy(s, *ptr, len);
+	s[len] = '\0';
+	*ptr += len;
+
+	/* Success */
+	return 0;
+}
+
+/*
+ * Read a variable length integer from a file.
+ */
+static int read_varint(FILE *fff, unsigned int *x)
+{
+	int c, shift = 0;
+
+	/* Clear value */
+	*x = 0;
+
+	/* Loop over bytes */
+	while (shift < 32 && (c = getc(fff)) != EOF)
+	{
+		/* Add low bits */
+		*x |= (unsigned int)(c & 0x7f) << shift;
+
+		/* Check for last byte */
+		if (!(c & 0x80)) return 0;
+
+		/* Move to next bits */
+		shift += 7;
+	}
+
+	/* Truncated or malformed value */
+	return -1;
+}
+
+/*
+ * Add a zigzag encoded signed integer to a buffer.
+ */
+static void put_zigzag(unsigned char **ptr, int x)
+{
+	/* Write encoded value */
+	put_varint(ptr, ((unsigned int)x << 1) ^ (unsigned int)(x >> 31));
+}
+
+/*
+ * Read a zigzag encoded signed integer from a buffer.
+ */
+static int get_zigzag(unsigned char **ptr, unsigned char *end, int *x)
+{
+	unsigned int u;
+
+	/* Read encoded value */
+	if (get_varint(ptr, end, &u) < 0) return -1;
+
+	/* Decode value */
+	*x = (int)(u >> 1) ^ -(int)(u & 1);
+
+	/* Success */
+	return 0;
+}
+
+/*
+ * Add a choice log to a buffer, storing list entries as differences.
+ */
+static void put_choice_log(unsigned char **ptr, int *log, int size)
+{
+	int pos = 0, i, k, n, prev;
+
+	/* Loop over choices */
+	while (pos < size)
+	{
+		/* Write type and return value */
+		for (i = 0; i < 2 && pos < size; i++) put_zigzag(ptr, log[pos++]);
+
+		/* Loop over list and special list */
+		for (k = 0; k < 2 && pos < size; k++)
+		{
+			/* Get list size */
+			n = log[pos];
+
+			/* Write list size */
+			put_zigzag(ptr, log[pos++]);
+
+			/* Treat rest of log as list if size is bad */
+			if (n < 0 || n > size - pos) n = size - pos;
+
+			/* Start list */
+			prev = 0;
+
+			/* Loop over list entries */
+			for (i = 0; i < n; i++)
+			{
+				/* Write difference from previous entry */
+				put_zigzag(ptr, log[pos] - prev);
+
+				/* Remember entry */
+				prev = log[pos++];
+			}
+		}
+	}
+}
+
+/*
+ * Read a choice log of the given size written by put_choice_log().
+ */
+static int get_choice_log(unsigned char **ptr, unsigned char *end, int *log,
+                          int size)
+{
+	int pos = 0, i, k, n, prev;
+
+	/* Loop over choices */
+	while (pos < size)
+	{
+		/* Read type and return value */
+		for (i = 0; i < 2 && pos < size; i++)
+		{
+			/* Read entry */
+			if (get_zigzag(ptr, end, &log[pos++]) < 0) return -1;
+		}
+
+		/* Loop over list and special list */
+		for (k = 0; k < 2 && pos < size; k++)
+		{
+			/* Read list size */
+			if (get_zigzag(ptr, end, &n) < 0) return -1;
+			log[pos++] = n;
+
+			/* Treat rest of log as list if size is bad */
+			if (n < 0 || n > size - pos) n = size - pos;
+
+			/* Start list */
+			prev = 0;
+
+			/* Loop over list entries */
+			for (i = 0; i < n; i++)
+			{
+				/* Read difference from previous entry */
+				if (get_zigzag(ptr, end, &log[pos]) < 0) return -1;
+
+				/* Add previous entry */
+				log[pos] += prev;
+				prev = log[pos++];
+			}
+		}
+	}
+
+	/* Success */
+	return 0;
+}
+
+/*
+ * Store a game offset as an index entry.
+ */
+static int write_index_entry(FILE *idx, long offset)
+{
+	unsigned char data[8];
+	int i;
+
+	/* Encode offset */
+	for (i = 0; i < 8; i++) data[i] = (unsigned char)(offset >> (8 * i));
+
+	/* Write entry */
+	return fwrite(data, 1, 8, idx) == 8 ? 0 : -1;
+}
+
+/*
+ * Make sure the index of an archive lists every game in it.
+ *
+ * Offsets are added in order, so the index is complete exactly when its
+ * last entry is the game that ends the archive.  Otherwise the index is
+ * missing, stale or from another archive, and is rebuilt by reading the
+ * length of every game.  The archive must be open for reading, and end
+ * is its size.
+ */
+static int check_archive_index(FILE *fff, char *idx_name, long end)
+{
+	FILE *idx;
+	unsigned char data[8];
+	unsigned int len;
+	long offset = 0, size;
+	int i;
+
+	/* Open index */
+	idx = fopen(idx_name, "rb");
+
+	/* Check for index */
+	if (idx)
+	{
+		/* Get index size */
+		fseek(idx, 0, SEEK_END);
+		size = ftell(idx);
+
+		/* Read last entry */
+		if (size >= 8 && size % 8 == 0 &&
+		    fseek(idx, size - 8, SEEK_SET) == 0 &&
+		    fread(data, 1, 8, idx) == 8)
+		{
+			/* Decode offset */
+			for (i = 7; i >= 0; i--) offset = (offset << 8) | data[i];
+		}
+
+		/* Close index */
+		fclose(idx);
+
+		/* Check for empty index of archive without games */
+		if (!size && end == strlen(ARCHIVE_MAGIC) + 1) return 0;
+
+		/* Check for last entry being the last game */
+		if (offset > 0 && offset < end &&
+		    fseek(fff, offset, SEEK_SET) == 0 &&
+		    read_varint(fff, &len) == 0 && ftell(fff) + len == end)
+		{
+			/* Index is complete */
+			return 0;
+		}
+	}
+
+	/* Start index over */
+	idx = fopen(idx_name, "wb");
+
+	/* Check for failure */
+	if (!idx) return -1;
+
+	/* Skip archive header */
+	fseek(fff, strlen(ARCHIVE_MAGIC) + 1, SEEK_SET);
+
+	/* Loop over games */
+	while ((offset = ftell(fff)) < end)
+	{
+		/* Read record length and skip record */
+		if (read_varint(fff, &len) < 0 || ftell(fff) + len > end ||
+		    fseek(fff, len, SEEK_CUR)) break;
+
+		/* Add game to index */
+		if (write_index_entry(idx, offset) < 0) break;
+	}
+
+	/* Close index */
+	if (fclose(idx)) return -1;
+
+	/* Success */
+	return 0;
+}
+
+/*
+ * Append a game to an archive, creating the archive if needed.
+ *
+ * If the game uses a pool of random bytes instead of a seed, it should
+ * be given in pool.  Players are stored starting with player_us.
+ */
+int archive_game(game *g, char *filename, int player_us,
+                 unsigned char *pool, int pool_len)
+{
+	FILE *fff, *idx;
+	player *p_ptr;
+	unsigned char *buf, *ptr, header[16];
+	char idx_name[1024];
+	long offset;
+	int i, n, size, created = 0;
+
+	/* Create index file name */
+	sprintf(idx_name, "%.1000s.idx", filename);
+
+	/* Open archive for reading and appending */
+	fff = fopen(filename, "a+b");
+
+	/* Check for failure */
+	if (!fff) return -1;
+
+	/* Go to end of archive */
+	fseek(fff, 0, SEEK_END);
+
+	/* Check for new archive */
+	if (ftell(fff) == 0)
+	{
+		/* Write archive header */
+		fputs(ARCHIVE_MAGIC, fff);
+		putc(ARCHIVE_VERSION, fff);
+
+		/* Archive was created */
+		created = 1;
+	}
+	else
+	{
+		/* Go to start of archive */
+		rewind(fff);
+
+		/* Read header */
+		if (fread(header, 1, strlen(ARCHIVE_MAGIC) + 1, fff) !=
+		    strlen(ARCHIVE_MAGIC) + 1 ||
+		    strncmp((char *)header, ARCHIVE_MAGIC, strlen(ARCHIVE_MAGIC)) ||
+		    header[strlen(ARCHIVE_MAGIC)] != ARCHIVE_VERSION)
+		{
+			/* Not an archive we can add to */
+			fclose(fff);
+			return -1;
+		}
+
+		/* Go back to end of archive */
+		fseek(fff, 0, SEEK_END);
+
+		/* Make sure index lists every game so far */
+		if (check_archive_index(fff, idx_name, ftell(fff)) < 0)
+		{
+			/* Index could not be rebuilt */
+			fclose(fff);
+			return -1;
+		}
+
+		/* Go back to end of archive */
+		fseek(fff, 0, SEEK_END);
+	}
+
+	/* Compute largest possible record size */
+	size = 64 + pool_len + 2 * 1024;
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Add room for choice log */
+		size += 5 + 5 * g->p[i].choice_unread_pos;
+	}
+
+	/* Create record buffer */
+	buf = (unsigned char *)malloc(size);
+
+	/* Start at beginning of buffer */
+	ptr = buf;
+
+	/* Write seed and setup information */
+	put_varint(&ptr, g->start_seed);
+	put_varint(&ptr, g->num_players);
+	put_varint(&ptr, g->expanded);
+	put_varint(&ptr, g->advanced);
+	put_varint(&ptr, g->goal_disabled);
+	put_varint(&ptr, g->takeover_disabled);
+
+	/* Write campaign name (if any) */
+	put_string(&ptr, g->camp ? g->camp->name : NULL);
+
+	/* Write name of human player (if any) */
+	put_string(&ptr, g->human_name && strlen(g->human_name) < 1024 ?
+	                 g->human_name : NULL);
+
+	/* Write random byte pool */
+	put_varint(&ptr, pool ? pool_len : 0);
+	if (pool) memcpy(ptr, pool, pool_len);
+	if (pool) ptr += pool_len;
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Get player index to save next */
+		n = (player_us + i) % g->num_players;
+
+		/* Get player pointer */
+		p_ptr = &g->p[n];
+
+		/* Write size of choice log */
+		put_varint(&ptr, p_ptr->choice_unread_pos);
+
+		/* Write choice log */
+		put_choice_log(&ptr, p_ptr->choice_log,
+		               p_ptr->choice_unread_pos);
+	}
+
+	/* Remember position of game */
+	offset = ftell(fff);
+
+	/* Write length of record */
+	n = ptr - buf;
+	while (n >= 0x80)
+	{
+		putc((n & 0x7f) | 0x80, fff);
+		n >>= 7;
+	}
+	putc(n, fff);
+
+	/* Write record */
+	fwrite(buf, 1, ptr - buf, fff);
+
+	/* Free buffer */
+	free(buf);
+
+	/* Check for write error */
+	if (fclose(fff)) return -1;
+
+	/* Open index, starting over if archive is new */
+	idx = fopen(idx_name, created ? "wb" : "ab");
+
+	/* Check for failure */
+	if (!idx) return -1;
+
+	/* Write game offset */
+	i = write_index_entry(idx, offset);
+
+	/* Close index */
+	if (fclose(idx)) return -1;
+
+	/* Return result */
+	return i;
+}
+
+/*
+ * Find the offset of the given game in an archive.
+ */
+static long find_archive_game(FILE *fff, char *filename, int which)
+{
+	FILE *idx;
+	unsigned char data[8];
+	char idx_name[1024];
+	unsigned int len;
+	long offset = 0;
+	int i;
+
+	/* Create index file name */
+	sprintf(idx_name, "%.1000s.idx", filename);
+
+	/* Open index */
+	idx = fopen(idx_name, "rb");
+
+	/* Check for index */
+	if (idx)
+	{
+		/* Read game offset */
+		if (fseek(idx, 8L * which, SEEK_SET) == 0 &&
+		    fread(data, 1, 8, idx) == 8)
+		{
+			/* Decode offset */
+			for (i = 7; i >= 0; i--) offset = (offset << 8) | data[i];
+		}
+
+		/* Close index */
+		fclose(idx);
+
+		/* Return offset if found inside archive */
+		if (offset && fseek(fff, 0, SEEK_END) == 0 && offset < ftell(fff))
+			return offset;
+	}
+
+	/* Skip archive header */
+	if (fseek(fff, strlen(ARCHIVE_MAGIC) + 1, SEEK_SET)) return -1;
+
+	/* Skip earlier games */
+	for (i = 0; i < which; i++)
+	{
+		/* Read record length */
+		if (read_varint(fff, &len) < 0) return -1;
+
+		/* Skip record */
+		if (fseek(fff, len, SEEK_CUR)) return -1;
+	}
+
+	/* Return current position */
+	return ftell(fff);
+}
+
+/*
+ * Load a game from an archive.
+ *
+ * Games are numbered from zero in the order they were added.  If the
+ * game used a pool of random bytes, it is copied to pool (which has room
+ * for *pool_len bytes), and *pool_len is set to its size.
+ */
+int load_archive_game(game *g, char *filename, int which,
+                      unsigned char *pool, int *pool_len)
+{
+	FILE *fff;
+	player *p_ptr;
+	unsigned char *buf, *ptr, *end;
+	char header[16], name[1024];
+	unsigned int len, x;
+	long offset;
+	int i;
+
+	/* Open archive for reading */
+	fff = fopen(filename, "rb");
+
+	/* Check for failure */
+	if (!fff) return -1;
+
+	/* Read header */
+	if (fread(header, 1, strlen(ARCHIVE_MAGIC) + 1, fff) !=
+	    strlen(ARCHIVE_MAGIC) + 1 ||
+	    strncmp(header, ARCHIVE_MAGIC, strlen(ARCHIVE_MAGIC)) ||
+	    header[strlen(ARCHIVE_MAGIC)] != ARCHIVE_VERSION)
+	{
+		/* Not an archive we can read */
+		fclose(fff);
+		return -1;
+	}
+
+	/* Find game */
+	offset = find_archive_game(fff, filename, which);
+
+	/* Go to game and read record length */
+	if (offset < 0 || fseek(fff, offset, SEEK_SET) ||
+	    read_varint(fff, &len) < 0)
+	{
+		/* Game not found */
+		fclose(fff);
+		return -1;
+	}
+
+	/* Create record buffer */
+	buf = (unsigned char *)malloc(len);
+
+	/* Read record */
+	if (fread(buf, 1, len, fff) != len)
+	{
+		/* Truncated archive */
+		free(buf);
+		fclose(fff);
+		return -1;
+	}
+
+	/* Close archive */
+	fclose(fff);
+
+	/* Start at beginning of record */
+	ptr = buf;
+	end = buf + len;
+
+	/* Read seed */
+	if (get_varint(&ptr, end, &x) < 0) goto error;
+	g->start_seed = x;
+
+	/* Read game setup information */
+	if (get_varint(&ptr, end, &x) < 0 || x < 2 || x > MAX_PLAYER)
+		goto error;
+	g->num_players = x;
+	if (get_varint(&ptr, end, &x) < 0 || x >= MAX_EXPANSION) goto error;
+	g->expanded = x;
+	if (get_varint(&ptr, end, &x) < 0) goto error;
+	g->advanced = x;
+	if (get_varint(&ptr, end, &x) < 0) goto error;
+	g->goal_disabled = x;
+	if (get_varint(&ptr, end, &x) < 0) goto error;
+	g->takeover_disabled = x;
+
+	/* Read campaign name */
+	if (get_string(&ptr, end, name, sizeof(name)) < 0) goto error;
+
+	/* Check for no campaign */
+	if (!strlen(name))
+	{
+		/* Clear campaign */
+		g->camp = NULL;
+	}
+	else
+	{
+		/* Get campaign */
+		g->camp = find_campaign(name);
+
+		/* Check for no campaign found */
+		if (!g->camp) goto error;
+	}
+
+	/* Read name of human player */
+	if (get_string(&ptr, end, name, sizeof(name)) < 0) goto error;
+
+	/* Set human name (if any) */
+	g->human_name = strlen(name) ? strdup(name) : NULL;
+
+	/* Read size of random byte pool */
+	if (get_varint(&ptr, end, &x) < 0 || x > end - ptr) goto error;
+
+	/* Check for pool wanted */
+	if (pool_len)
+	{
+		/* Check for too large pool */
+		if (x > *pool_len) goto error;
+
+		/* Copy pool */
+		memcpy(pool, ptr, x);
+
+		/* Set pool size */
+		*pool_len = x;
+	}
+
+	/* Skip pool */
+	ptr += x;
+
+	/* Clear other options */
+	g->promo = 0;
+
+	/* Clear simulation flag */
+	g->simulation = 0;
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Get player pointer */
+		p_ptr = &g->p[i];
+
+		/* Read choice log size */
+		if (get_varint(&ptr, end, &x) < 0 || x > ARCHIVE_MAX_LOG)
+			goto error;
+		p_ptr->choice_size = x;
+
+		/* Read choice log */
+		if (get_choice_log(&ptr, end, p_ptr->choice_log,
+		                   p_ptr->choice_size) < 0) goto error;
+
+		/* Reset choice log position */
+		p_ptr->choice_pos = 0;
+	}
+
+	/* Free record buffer */
+	free(buf);
+
+	/* Success */
+	return 0;
+
+error:
+	/* Free record buffer */
+	free(buf);
+
+	/* Malformed record */
+	return -1;
+}
+
 /*
  * Function to compare two cards in a table for sorting.
  */
@@ -375,8 +1153,9 @@ static void export_cards(FILE *fff, char *header, game *g, int n, card **cards,
 		/* XXX Check whether card is a temporary explore card */
 		exp = g->cur_action == ACT_EXPLORE_5_0 &&
 		      cards[p]->where == WHERE_HAND &&
-		      (cards[p]->start_where != WHERE_HAND ||
-		       cards[p]->start_owner != cards[p]->owner);
+		      (card_start_where(g, cards[p] - g->deck) != WHERE_HAND ||
+		       card_start_owner(g, cards[p] - g->deck) !=
+		       cards[p]->owner);
 
 		/* Check for any goods on card */
 		if (cards[p]->num_goods > 0)
@@ -492,29 +1271,11 @@ static void export_locations(FILE *fff, game *g, int who,
 }
 
 /*
- * Export the game state to the given filename.
+ * Write the XML header, top level tag, version and server of an export.
  */
-int export_game(game *g, char *filename, char *style_sheet,
-                char *server, int player_us, const char *message,
-                int num_special_cards, card **special_cards,
-                int export_card_locations,
-                void (*export_log)(FILE *fff, int gid),
-                void (*export_callback)(FILE *fff, int gid), int gid)
+void write_export_start(FILE *fff, char *style_sheet, char *top,
+                        char *server)
 {
-	FILE *fff;
-	player *p_ptr;
-	card *c_ptr;
-	int p, i, n, count, deck = 0, discard = 0, act[2];
-
-	/* Open file for writing */
-	fff = fopen(filename, "w");
-
-	/* Check for failure */
-	if (!fff) return -1;
-
-	/* Score game to get end totals */
-	score_game(g);
-
 	/* Write header */
 	fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", fff);
 
@@ -527,7 +1288,7 @@ int export_game(game *g, char *filename, char *style_sheet,
 	}
 
 	/* Write top level tag */
-	fputs("<RftgExport>\n", fff);
+	fprintf(fff, "<%s>\n", top);
 
 	/* Write version */
 	fprintf(fff, "  <Version>%s</Version>\n", RELEASE);
@@ -538,15 +1299,13 @@ int export_game(game *g, char *filename, char *style_sheet,
 		/* Write server */
 		fprintf(fff, "  <Server>%s</Server>\n", xml_escape(server));
 	}
+}
 
-	/* Check for player */
-	if (player_us != -1)
-	{
-		/* Write player name */
-		fprintf(fff, "  <PlayerName>%s</PlayerName>\n",
-		        xml_escape(g->p[player_us].name));
-	}
-
+/*
+ * Write the setup of a game export.
+ */
+void write_export_setup(game *g, FILE *fff)
+{
 	/* Write setup start tag */
 	fputs("  <Setup>\n", fff);
 
@@ -575,6 +1334,15 @@ int export_game(game *g, char *filename, char *style_sheet,
 
 	/* Write end tag */
 	fputs("  </Setup>\n", fff);
+}
+
+/*
+ * Write the status of a game export.
+ */
+void write_export_status(game *g, FILE *fff, const char *message)
+{
+	card *c_ptr;
+	int i, deck = 0, discard = 0;
 
 	/* Write status start tag */
 	fputs("  <Status>\n", fff);
@@ -646,203 +1414,250 @@ int export_game(game *g, char *filename, char *style_sheet,
 
 	/* Write end tag */
 	fputs("  </Status>\n", fff);
+}
 
-	/* Loop over players */
-	for (p = 0; p < g->num_players; p++)
-	{
-		/* Get player index to save next */
-		n = player_us == -1 ? p : (player_us + 1 + p) % g->num_players;
+/*
+ * Write one player of a game export (as seen from a specific player).
+ */
+void write_export_player(game *g, FILE *fff, int n, int player_us,
+                         int num_special_cards, card **special_cards)
+{
+	player *p_ptr;
+	int i, count, act[2];
 
-		/* Get player pointer */
-		p_ptr = &g->p[n];
+	/* Get player pointer */
+	p_ptr = &g->p[n];
 
-		/* Write player start tag */
-		fprintf(fff, "  <Player id=\"%d\"%s%s>\n", n,
-		        p_ptr->ai ? " ai=\"yes\"" : "",
-		        p_ptr->winner ? " winner=\"yes\"" : "");
+	/* Write player start tag */
+	fprintf(fff, "  <Player id=\"%d\"%s%s>\n", n,
+	        p_ptr->ai ? " ai=\"yes\"" : "",
+	        p_ptr->winner ? " winner=\"yes\"" : "");
 
-		/* Write player name */
-		fprintf(fff, "    <Name>%s</Name>\n", xml_escape(p_ptr->name));
+	/* Write player name */
+	fprintf(fff, "    <Name>%s</Name>\n", xml_escape(p_ptr->name));
 
-		/* Assume actions aren't known */
-		act[0] = act[1] = -1;
+	/* Assume actions aren't known */
+	act[0] = act[1] = -1;
 
-		/* Check for actions known */
-		if (g->advanced && g->cur_action < ACT_SEARCH &&
-		    player_us != -1 && player_us == n &&
-		    count_active_flags(g, player_us, FLAG_SELECT_LAST))
-		{
-			/* Copy first action only */
-			act[0] = p_ptr->action[0];
-		}
-		else if (g->cur_action >= ACT_SEARCH || player_us == -1 ||
-		         count_active_flags(g, player_us, FLAG_SELECT_LAST))
-		{
-			/* Copy both actions */
-			act[0] = p_ptr->action[0];
-			act[1] = p_ptr->action[1];
-		}
+	/* Check for actions known */
+	if (g->advanced && g->cur_action < ACT_SEARCH &&
+	    player_us != -1 && player_us == n &&
+	    count_active_flags(g, player_us, FLAG_SELECT_LAST))
+	{
+		/* Copy first action only */
+		act[0] = p_ptr->action[0];
+	}
+	else if (g->cur_action >= ACT_SEARCH || player_us == -1 ||
+	         count_active_flags(g, player_us, FLAG_SELECT_LAST))
+	{
+		/* Copy both actions */
+		act[0] = p_ptr->action[0];
+		act[1] = p_ptr->action[1];
+	}
 
-		/* Write action start tag */
-		fputs("    <Actions>\n", fff);
+	/* Write action start tag */
+	fputs("    <Actions>\n", fff);
 
-		/* Loop over actions */
-		for (i = 0; i < 2; ++i)
-		{
-			/* Write action if known */
-			if (act[i] != -1)
-				fprintf(fff, "      <Action id=\"%d\">%s</Action>\n",
-				        act[i], xml_escape(action_name(act[i])));
-		}
+	/* Loop over actions */
+	for (i = 0; i < 2; ++i)
+	{
+		/* Write action if known */
+		if (act[i] != -1)
+			fprintf(fff, "      <Action id=\"%d\">%s</Action>\n",
+			        act[i], xml_escape(action_name(act[i])));
+	}
 
-		/* Write end tag */
-		fputs("    </Actions>\n", fff);
+	/* Write end tag */
+	fputs("    </Actions>\n", fff);
 
-		/* Check for expansion with prestige*/
-		if (exp_info[g->expanded].has_prestige)
-		{
-			/* Write prestige, whether prestige action is used and */
-			/* whether prestige is on the tile */
-			fprintf(fff, "    <Prestige actionUsed=\"%s\"%s>%d</Prestige>\n",
-			        p_ptr->prestige_action_used ? "yes" : "no",
-			        prestige_on_tile(g, n) ? " onTile=\"yes\"" : "",
-			        p_ptr->prestige);
-		}
+	/* Check for expansion with prestige*/
+	if (exp_info[g->expanded].has_prestige)
+	{
+		/* Write prestige, whether prestige action is used and */
+		/* whether prestige is on the tile */
+		fprintf(fff, "    <Prestige actionUsed=\"%s\"%s>%d</Prestige>\n",
+		        p_ptr->prestige_action_used ? "yes" : "no",
+		        prestige_on_tile(g, n) ? " onTile=\"yes\"" : "",
+		        p_ptr->prestige);
+	}
 
-		/* Write acquired chips */
-		fprintf(fff, "    <Chips>%d</Chips>\n", p_ptr->vp);
+	/* Write acquired chips */
+	fprintf(fff, "    <Chips>%d</Chips>\n", p_ptr->vp);
 
-		/* Write current score */
-		fprintf(fff, "    <Score>%d</Score>\n", p_ptr->end_vp);
+	/* Write current score */
+	fprintf(fff, "    <Score>%d</Score>\n", p_ptr->end_vp);
 
-		/* Check for goals enabled */
-		if (goals_enabled(g))
-		{
-			/* Write goals start tag*/
-			fputs("    <Goals>\n", fff);
+	/* Check for goals enabled */
+	if (goals_enabled(g))
+	{
+		/* Write goals start tag*/
+		fputs("    <Goals>\n", fff);
 
-			/* Loop over goals */
-			for (i = 0; i < MAX_GOAL; ++i)
+		/* Loop over goals */
+		for (i = 0; i < MAX_GOAL; ++i)
+		{
+			/* Check if player has goal */
+			if (p_ptr->goal_claimed[i])
 			{
-				/* Check if player has goal */
-				if (p_ptr->goal_claimed[i])
-				{
-					/* Write goal */
-					fprintf(fff, "      <Goal id=\"%d\">%s</Goal>\n",
-					        i, xml_escape(goal_name[i]));
-					continue;
-				}
-
-				/* Check for insufficient progress */
-				if (p_ptr->goal_progress[i] < goal_minimum(i))
-					continue;
+				/* Write goal */
+				fprintf(fff, "      <Goal id=\"%d\">%s</Goal>\n",
+				        i, xml_escape(goal_name[i]));
+				continue;
+			}
 
-				/* Check for less progress than other players */
-				if (p_ptr->goal_progress[i] < g->goal_most[i])
-					continue;
+			/* Check for insufficient progress */
+			if (p_ptr->goal_progress[i] < goal_minimum(i))
+				continue;
 
-				/* Write unclaimed goal */
-				fprintf(fff, "      <Goal id=\"%d\" shared=\"yes\">%s"
-				        "</Goal>\n", i, xml_escape(goal_name[i]));
-			}
+			/* Check for less progress than other players */
+			if (p_ptr->goal_progress[i] < g->goal_most[i])
+				continue;
 
-			/* Write end tag */
-			fputs("    </Goals>\n", fff);
+			/* Write unclaimed goal */
+			fprintf(fff, "      <Goal id=\"%d\" shared=\"yes\">%s"
+			        "</Goal>\n", i, xml_escape(goal_name[i]));
 		}
 
-		/* Write tableau */
-		export_linked_cards(fff, "Tableau", g, p_ptr->head[WHERE_ACTIVE],
-		                    cmp_table);
+		/* Write end tag */
+		fputs("    </Goals>\n", fff);
+	}
 
-		/* Check for saved cards */
-		if (count_active_flags(g, n, FLAG_START_SAVE))
+	/* Write tableau */
+	export_linked_cards(fff, "Tableau", g, p_ptr->head[WHERE_ACTIVE],
+	                    cmp_table);
+
+	/* Check for saved cards */
+	if (count_active_flags(g, n, FLAG_START_SAVE))
+	{
+		/* Reset count */
+		count = 0;
+
+		/* Loop over cards in deck */
+		for (i = 0; i < g->deck_size; i++)
 		{
-			/* Reset count */
-			count = 0;
+			/* Count cards saved */
+			if (g->deck[i].where == WHERE_SAVED) count++;
+		}
 
+		/* Write saved start tag */
+		fprintf(fff, "    <Saved count=\"%d\">\n", count);
+
+		/* Check for known saved cards */
+		if (player_us == -1 || player_us == n)
+		{
 			/* Loop over cards in deck */
 			for (i = 0; i < g->deck_size; i++)
 			{
-				/* Count cards saved */
-				if (g->deck[i].where == WHERE_SAVED) count++;
-			}
-
-			/* Write saved start tag */
-			fprintf(fff, "    <Saved count=\"%d\">\n", count);
-
-			/* Check for known saved cards */
-			if (player_us == -1 || player_us == n)
-			{
-				/* Loop over cards in deck */
-				for (i = 0; i < g->deck_size; i++)
+				/* Write saved card */
+				if (g->deck[i].where == WHERE_SAVED)
 				{
-					/* Write saved card */
-					if (g->deck[i].where == WHERE_SAVED)
-					{
-						/* Write card name */
-						fprintf(fff, "      <Card id=\"%d\">%s</Card>\n",
-						        g->deck[i].d_ptr->index,
-						        xml_escape(g->deck[i].d_ptr->name));
-					}
+					/* Write card name */
+					fprintf(fff, "      <Card id=\"%d\">%s</Card>\n",
+					        g->deck[i].d_ptr->index,
+					        xml_escape(g->deck[i].d_ptr->name));
 				}
 			}
-
-			/* Write end tag */
-			fprintf(fff, "    </Saved>\n");
 		}
 
-		/* Check for known hand */
-		if (player_us == -1 || player_us == n)
-		{
-			/* Write human player's hand */
-			export_linked_cards(fff, "Hand", g, p_ptr->head[WHERE_HAND],
-			                    cmp_hand);
+		/* Write end tag */
+		fprintf(fff, "    </Saved>\n");
+	}
+
+	/* Check for known hand */
+	if (player_us == -1 || player_us == n)
+	{
+		/* Write human player's hand */
+		export_linked_cards(fff, "Hand", g, p_ptr->head[WHERE_HAND],
+		                    cmp_hand);
 
-			/* Check for special cards passed */
-			if (num_special_cards)
+		/* Check for special cards passed */
+		if (num_special_cards)
+		{
+			/* Check action */
+			switch (g->cur_action)
 			{
-				/* Check action */
-				switch (g->cur_action)
-				{
-					/* Start world choice */
-					case ACT_GAME_START:
-						export_cards(fff, "Start", g, num_special_cards,
-						             special_cards, NULL);
-						break;
-
-					/* Search */
-					case ACT_SEARCH:
-						export_cards(fff, "Search", g, num_special_cards,
-						             special_cards, cmp_hand);
-						break;
-
-					/* Save discarded cards */
-					case ACT_DEVELOP:
-					case ACT_SETTLE:
-						export_cards(fff, "Discards", g, num_special_cards,
-						             special_cards, cmp_hand);
-						break;
-
-					/* Gamble */
-					case ACT_CONSUME_TRADE:
-						export_cards(fff, "Flips", g, num_special_cards,
-						             special_cards, cmp_hand);
-						break;
-				}
+				/* Start world choice */
+				case ACT_GAME_START:
+					export_cards(fff, "Start", g, num_special_cards,
+					             special_cards, NULL);
+					break;
+
+				/* Search */
+				case ACT_SEARCH:
+					export_cards(fff, "Search", g, num_special_cards,
+					             special_cards, cmp_hand);
+					break;
+
+				/* Save discarded cards */
+				case ACT_DEVELOP:
+				case ACT_SETTLE:
+					export_cards(fff, "Discards", g, num_special_cards,
+					             special_cards, cmp_hand);
+					break;
+
+				/* Gamble */
+				case ACT_CONSUME_TRADE:
+					export_cards(fff, "Flips", g, num_special_cards,
+					             special_cards, cmp_hand);
+					break;
 			}
 		}
-		else
-		{
-			/* Write hand size */
-			fprintf(fff, "    <Hand count=\"%d\">\n",
-			        count_player_area(g, n, WHERE_HAND));
-
-			/* Write end tag */
-			fputs("    </Hand>\n", fff);
-		}
+	}
+	else
+	{
+		/* Write hand size */
+		fprintf(fff, "    <Hand count=\"%d\">\n",
+		        count_player_area(g, n, WHERE_HAND));
 
 		/* Write end tag */
-		fputs("  </Player>\n", fff);
+		fputs("    </Hand>\n", fff);
+	}
+
+	/* Write end tag */
+	fputs("  </Player>\n", fff);
+}
+
+/*
+ * Write an export of the game state to the given file.
+ */
+void write_export(game *g, FILE *fff, char *style_sheet,
+                  char *server, int player_us, const char *message,
+                  int num_special_cards, card **special_cards,
+                  int export_card_locations,
+                  void (*export_log)(FILE *fff, int gid),
+                  void (*export_callback)(FILE *fff, int gid), int gid)
+{
+	int p, n;
+
+	/* Score game to get end totals */
+	score_game(g);
+
+	/* Write header */
+	write_export_start(fff, style_sheet, "RftgExport", server);
+
+	/* Check for player */
+	if (player_us != -1)
+	{
+		/* Write player name */
+		fprintf(fff, "  <PlayerName>%s</PlayerName>\n",
+		        xml_escape(g->p[player_us].name));
+	}
+
+	/* Write setup */
+	write_export_setup(g, fff);
+
+	/* Write status */
+	write_export_status(g, fff, message);
+
+	/* Loop over players */
+	for (p = 0; p < g->num_players; p++)
+	{
+		/* Get player index to save next */
+		n = player_us == -1 ? p : (player_us + 1 + p) % g->num_players;
+
+		/* Write player */
+		write_export_player(g, fff, n, player_us, num_special_cards,
+		                    special_cards);
 	}
 
 	if (export_log)
@@ -879,6 +1694,30 @@ int export_game(game *g, char *filename, char *style_sheet,
 
 	/* End top level tag */
 	fputs("</RftgExport>\n", fff);
+}
+
+/*
+ * Export a game to the given filename.
+ */
+int export_game(game *g, char *filename, char *style_sheet,
+                char *server, int player_us, const char *message,
+                int num_special_cards, card **special_cards,
+                int export_card_locations,
+                void (*export_log)(FILE *fff, int gid),
+                void (*export_callback)(FILE *fff, int gid), int gid)
+{
+	FILE *fff;
+
+	/* Open file for writing */
+	fff = fopen(filename, "w");
+
+	/* Check for failure */
+	if (!fff) return -1;
+
+	/* Write game export to file */
+	write_export(g, fff, style_sheet, server, player_us, message,
+	             num_special_cards, special_cards, export_card_locations,
+	             export_log, export_callback, gid);
 
 	/* Close file */
 	fclose(fff);
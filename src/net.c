@@ -23,9 +23,9 @@
 #include "net.h"
 
 /*
- * Maximum number of previous input sets.
+ * Number of network computations performed (for benchmarking).
  */
-#define PAST_MAX 120
+long net_num_computes;
 
 /*
  * Create a random weight value.
@@ -36,6 +36,37 @@ static void init_weight(double *wgt)
 	*wgt = 0.2 * rand() / RAND_MAX - 0.1;
 }
 
+/*
+ * Create an array of rows that share one contiguous block.
+ */
+static double **make_matrix(int rows, int cols)
+{
+	double **matrix;
+	int i;
+
+	/* Create array of rows */
+	matrix = (double **)malloc(sizeof(double *) * rows);
+
+	/* Create block for all rows */
+	matrix[0] = (double *)malloc(sizeof(double) * rows * cols);
+
+	/* Point rows into block */
+	for (i = 1; i < rows; i++) matrix[i] = matrix[0] + i * cols;
+
+	/* Return matrix */
+	return matrix;
+}
+
+/*
+ * Destroy a matrix created by make_matrix().
+ */
+static void free_matrix(double **matrix)
+{
+	/* Free block and array of rows */
+	free(matrix[0]);
+	free(matrix);
+}
+
 /*
  * Create a network of the given size.
  */
@@ -70,6 +101,9 @@ void make_learner(net *learn, int input, int hidden, int output)
 	/* Create hidden error array */
 	learn->hidden_error = (double *)malloc(sizeof(double) * hidden);
 
+	/* Create hidden correction factor array */
+	learn->hidden_corr = (double *)malloc(sizeof(double) * hidden);
+
 	/* Create output result array */
 	learn->net_result = (double *)malloc(sizeof(double) * output);
 
@@ -81,24 +115,14 @@ void make_learner(net *learn, int input, int hidden, int output)
 	learn->hidden_result[hidden] = 1.0;
 
 	/* Create rows of hidden weights */
-	learn->hidden_weight = (double **)malloc(sizeof(double *) *
-	                                         (input + 1));
+	learn->hidden_weight = make_matrix(input + 1, hidden);
 
 	/* Create rows of hidden weight deltas */
-	learn->hidden_delta = (double **)malloc(sizeof(double *) *
-	                                        (input + 1));
+	learn->hidden_delta = make_matrix(input + 1, hidden);
 
 	/* Loop over hidden weight rows */
 	for (i = 0; i < input + 1; i++)
 	{
-		/* Create weight row */
-		learn->hidden_weight[i] = (double *)malloc(sizeof(double) *
-		                                           hidden);
-
-		/* Create weight delta row */
-		learn->hidden_delta[i] = (double *)malloc(sizeof(double) *
-		                                          hidden);
-
 		/* Randomize weights */
 		for (j = 0; j < hidden; j++)
 		{
@@ -111,24 +135,14 @@ void make_learner(net *learn, int input, int hidden, int output)
 	}
 
 	/* Create rows of output weights */
-	learn->output_weight = (double **)malloc(sizeof(double *) *
-	                                         (hidden + 1));
+	learn->output_weight = make_matrix(hidden + 1, output);
 
 	/* Create rows of output weight deltas */
-	learn->output_delta = (double **)malloc(sizeof(double *) *
-	                                        (hidden + 1));
+	learn->output_delta = make_matrix(hidden + 1, output);
 
 	/* Loop over output weight rows */
 	for (i = 0; i < hidden + 1; i++)
 	{
-		/* Create weight row */
-		learn->output_weight[i] = (double *)malloc(sizeof(double) *
-		                                           output);
-
-		/* Create weight delta row */
-		learn->output_delta[i] = (double *)malloc(sizeof(double) *
-		                                          output);
-
 		/* Randomize weights */
 		for (j = 0; j < output; j++)
 		{
@@ -149,18 +163,46 @@ void make_learner(net *learn, int input, int hidden, int output)
 	/* Clear previous inputs */
 	memset(learn->prev_input, 0, sizeof(double) * (input + 1));
 
+	/* Current sums and previous inputs are the only accumulator slot */
+	learn->slot_sum = (double **)malloc(sizeof(double *));
+	learn->slot_prev = (double **)malloc(sizeof(double *));
+	learn->slot_sum[0] = learn->hidden_sum;
+	learn->slot_prev[0] = learn->prev_input;
+	learn->num_slot = 1;
+	learn->cur_slot = 0;
+
+	/* No pushed states or logged changes */
+	learn->push_sum = NULL;
+	learn->push_slot = learn->push_mark = NULL;
+	learn->num_push = learn->max_push = 0;
+	learn->change = NULL;
+	learn->num_change = learn->max_change = 0;
+
 	/* Create set of previous inputs */
 	learn->past_input = (double **)malloc(sizeof(double *) * PAST_MAX);
 
+	/* Create space for each set of previous inputs */
+	for (i = 0; i < PAST_MAX; i++)
+	{
+		/* Create input set */
+		learn->past_input[i] = (double *)malloc(sizeof(double) *
+		                                        (input + 1));
+	}
+
 	/* Create set of previous input players */
 	learn->past_input_player = (int *)malloc(sizeof(int) * PAST_MAX);
 
 	/* No past inputs available */
-	learn->num_past = 0;
+	learn->past_first = learn->num_past = 0;
 
 	/* No training done */
 	learn->num_training = 0;
 
+	/* No batch arrays yet */
+	learn->batch_hidden = learn->batch_corr = NULL;
+	learn->batch_prob = learn->batch_error = NULL;
+	learn->batch_max = 0;
+
 	/* Create array for input names */
 	learn->input_name = (char **)malloc(sizeof(char *) * input);
 
@@ -188,6 +230,34 @@ static double sigmoid(double x)
 typedef double v2d __attribute__ ((vector_size (16)));
 #endif
 
+/*
+ * Log a change to an input of the current accumulator slot.
+ */
+static void log_change(net *learn, int i)
+{
+	net_change *c_ptr;
+
+	/* Check for full log */
+	if (learn->num_change == learn->max_change)
+	{
+		/* Double log size */
+		learn->max_change = learn->max_change ?
+		                    learn->max_change * 2 : 1024;
+
+		/* Grow log */
+		learn->change = (net_change *)realloc(learn->change,
+		                 sizeof(net_change) * learn->max_change);
+	}
+
+	/* Get log entry */
+	c_ptr = &learn->change[learn->num_change++];
+
+	/* Remember input and its old value */
+	c_ptr->prev = learn->prev_input;
+	c_ptr->index = i;
+	c_ptr->value = learn->prev_input[i];
+}
+
 /*
  * Compute a neural net's result.
  */
@@ -199,6 +269,9 @@ void compute_net(net *learn)
 	v2d *weight, *hid_sum;
 #endif
 
+	/* Count computation */
+	net_num_computes++;
+
 	/* Loop over inputs */
 	for (i = 0; i < learn->num_inputs + 1; i++)
 	{
@@ -255,6 +328,9 @@ void compute_net(net *learn)
 			}
 #endif
 
+			/* Log change if states are pushed */
+			if (learn->num_push) log_change(learn, i);
+
 			/* Store input */
 			learn->prev_input[i] = learn->input_value[i];
 		}
@@ -306,6 +382,185 @@ void compute_net(net *learn)
 	}
 }
 
+/*
+ * Make sure a network has at least the given number of accumulator slots.
+ *
+ * Each slot remembers the hidden sums of the last inputs computed with
+ * it, so that inputs which alternate between a few different patterns
+ * (such as game states seen by each player) can each be computed
+ * incrementally from the last inputs of the same pattern.
+ */
+void make_net_slots(net *learn, int num)
+{
+	int i;
+
+	/* Check for enough slots */
+	if (num <= learn->num_slot) return;
+
+	/* Grow arrays of slots */
+	learn->slot_sum = (double **)realloc(learn->slot_sum,
+	                                     sizeof(double *) * num);
+	learn->slot_prev = (double **)realloc(learn->slot_prev,
+	                                      sizeof(double *) * num);
+
+	/* Loop over new slots */
+	for (i = learn->num_slot; i < num; i++)
+	{
+		/* Create cleared sums and previous inputs */
+		learn->slot_sum[i] = (double *)calloc(learn->num_hidden,
+		                                      sizeof(double));
+		learn->slot_prev[i] = (double *)calloc(learn->num_inputs + 1,
+		                                       sizeof(double));
+	}
+
+	/* Remember number of slots */
+	learn->num_slot = num;
+}
+
+/*
+ * Compute further results with the given accumulator slot.
+ */
+void use_net_slot(net *learn, int slot)
+{
+	/* Switch sums and previous inputs */
+	learn->hidden_sum = learn->slot_sum[slot];
+	learn->prev_input = learn->slot_prev[slot];
+
+	/* Remember current slot */
+	learn->cur_slot = slot;
+}
+
+/*
+ * Save the state of the current accumulator slot.
+ *
+ * Inputs computed before the matching pop_net() are logged, so that the
+ * slot can be returned to the saved inputs without recomputing them.
+ * Searches can push the state of a position before trying each of its
+ * alternatives, so that each alternative is computed from the position
+ * instead of from the previous alternative.
+ */
+void push_net(net *learn)
+{
+	int n;
+
+	/* Check for full stack */
+	if (learn->num_push == learn->max_push)
+	{
+		/* Grow stack */
+		learn->max_push = learn->max_push ? learn->max_push * 2 : 8;
+
+		/* Reallocate arrays */
+		learn->push_sum = (double *)realloc(learn->push_sum,
+		                  sizeof(double) * learn->max_push *
+		                  learn->num_hidden);
+		learn->push_slot = (int *)realloc(learn->push_slot,
+		                   sizeof(int) * learn->max_push);
+		learn->push_mark = (int *)realloc(learn->push_mark,
+		                   sizeof(int) * learn->max_push);
+	}
+
+	/* Get stack position */
+	n = learn->num_push++;
+
+	/* Save hidden sums */
+	memcpy(learn->push_sum + n * learn->num_hidden, learn->hidden_sum,
+	       sizeof(double) * learn->num_hidden);
+
+	/* Save slot and log position */
+	learn->push_slot[n] = learn->cur_slot;
+	learn->push_mark[n] = learn->num_change;
+}
+
+/*
+ * Return an accumulator slot to the state saved by the last push_net(),
+ * and make it current.
+ */
+void pop_net(net *learn)
+{
+	net_change *c_ptr;
+	double *prev;
+	int i, j, n, slot;
+
+	/* Check for nothing pushed (or discarded by training) */
+	if (!learn->num_push) return;
+
+	/* Get stack position */
+	n = --learn->num_push;
+
+	/* Get saved slot and its previous inputs */
+	slot = learn->push_slot[n];
+	prev = learn->slot_prev[slot];
+
+	/* Undo logged changes to slot (newest first) */
+	for (i = learn->num_change - 1; i >= learn->push_mark[n]; i--)
+	{
+		/* Get log entry */
+		c_ptr = &learn->change[i];
+
+		/* Restore old value if change was to this slot */
+		if (c_ptr->prev == prev) prev[c_ptr->index] = c_ptr->value;
+	}
+
+	/* Restore hidden sums */
+	memcpy(learn->slot_sum[slot], learn->push_sum + n * learn->num_hidden,
+	       sizeof(double) * learn->num_hidden);
+
+	/* Start of log entries made since push */
+	j = learn->push_mark[n];
+
+	/* Keep entries for other slots still pushed further down */
+	for (i = j; i < learn->num_change; i++)
+	{
+		/* Get log entry */
+		c_ptr = &learn->change[i];
+
+		/* Skip entries already undone */
+		if (c_ptr->prev == prev) continue;
+
+		/* Loop over states still pushed */
+		for (slot = 0; slot < n; slot++)
+		{
+			/* Check for entry's slot */
+			if (learn->slot_prev[learn->push_slot[slot]] ==
+			    c_ptr->prev) break;
+		}
+
+		/* Keep entry if its slot is still pushed */
+		if (slot < n) learn->change[j++] = *c_ptr;
+	}
+
+	/* Remember log size */
+	learn->num_change = j;
+
+	/* Make slot current */
+	use_net_slot(learn, learn->push_slot[n]);
+}
+
+/*
+ * Clear the hidden sums of every accumulator slot.
+ *
+ * This must be done when the weights are about to change.
+ */
+static void clear_slots(net *learn)
+{
+	int i;
+
+	/* Pushed states are no longer valid */
+	learn->num_push = learn->num_change = 0;
+
+	/* Loop over slots */
+	for (i = 0; i < learn->num_slot; i++)
+	{
+		/* Clear sums */
+		memset(learn->slot_sum[i], 0,
+		       sizeof(double) * learn->num_hidden);
+
+		/* Clear previous inputs */
+		memset(learn->slot_prev[i], 0,
+		       sizeof(double) * (learn->num_inputs + 1));
+	}
+}
+
 /*
  * Store the current inputs into the past set array.
  */
@@ -316,34 +571,22 @@ void store_net(net *learn, int who)
 	/* Check for too many past inputs already */
 	if (learn->num_past == PAST_MAX)
 	{
-		/* Destroy oldest set */
-		free(learn->past_input[0]);
-
-		/* Move all inputs up one spot */
-		for (i = 0; i < PAST_MAX - 1; i++)
-		{
-			/* Move one set of inputs */
-			learn->past_input[i] = learn->past_input[i + 1];
-
-			/* Move one player index */
-			learn->past_input_player[i] =
-			                  learn->past_input_player[i + 1];
-		}
+		/* Overwrite oldest set */
+		learn->past_first = (learn->past_first + 1) % PAST_MAX;
 
 		/* We now have one fewer set */
 		learn->num_past--;
 	}
 
-	/* Make space for new inputs */
-	learn->past_input[learn->num_past] = malloc(sizeof(double) *
-	                                            (learn->num_inputs + 1));
+	/* Get ring buffer position for new inputs */
+	i = PAST_INDEX(learn, learn->num_past);
 
 	/* Copy inputs */
-	memcpy(learn->past_input[learn->num_past], learn->input_value,
+	memcpy(learn->past_input[i], learn->input_value,
 	       sizeof(double) * (learn->num_inputs + 1));
 
 	/* Copy player index */
-	learn->past_input_player[learn->num_past] = who;
+	learn->past_input_player[i] = who;
 
 	/* One additional set */
 	learn->num_past++;
@@ -354,17 +597,8 @@ void store_net(net *learn, int who)
  */
 void clear_store(net *learn)
 {
-	int i;
-
-	/* Loop over previous stored inputs */
-	for (i = 0; i < learn->num_past; i++)
-	{
-		/* Free inputs */
-		free(learn->past_input[i]);
-	}
-
 	/* Clear number of past inputs */
-	learn->num_past = 0;
+	learn->past_first = learn->num_past = 0;
 }
 
 /*
@@ -424,8 +658,8 @@ void train_net(net *learn, double lambda, double *desired)
 		learn->output_delta[j][i] += learn->alpha * -error * deriv;
 	}
 
-	/* Create array of hidden weight correction factors */
-	hidden_corr = (double *)malloc(sizeof(double) * learn->num_hidden);
+	/* Get array of hidden weight correction factors */
+	hidden_corr = learn->hidden_corr;
 
 	/* Loop over hidden nodes */
 	for (i = 0; i < learn->num_hidden; i++)
@@ -452,21 +686,15 @@ void train_net(net *learn, double lambda, double *desired)
 		}
 	}
 
-	/* Destroy hidden correction factor array */
-	free(hidden_corr);
-
 	/* Loop over hidden nodes */
 	for (i = 0; i < learn->num_hidden; i++)
 	{
 		/* Clear node's error */
 		learn->hidden_error[i] = 0;
-
-		/* Clear node's stored sum */
-		learn->hidden_sum[i] = 0;
 	}
 
-	/* Clear previous inputs */
-	memset(learn->prev_input, 0, sizeof(double) * (learn->num_inputs + 1));
+	/* Clear stored sums and previous inputs */
+	clear_slots(learn);
 
 #ifdef NOISY
 	compute_net();
@@ -478,39 +706,239 @@ void train_net(net *learn, double lambda, double *desired)
 }
 
 /*
- * Apply accumulated training information.
+ * Train a network on a batch of input sets at once.
+ *
+ * Each input set is weighted by its lambda (or 1.0 if lambda is NULL).
+ * The corrections are the same as calling compute_net() and train_net()
+ * for each set in turn, and are likewise accumulated until
+ * apply_training() is called.
  */
-void apply_training(net *learn)
+void train_net_batch(net *learn, int num, double **input, double *lambda,
+                     double **desired)
 {
-	int i, j;
+	int hidden = learn->num_hidden, output = learn->num_output;
+	double *hid, *corr, *prob, *err, *row, *delta;
+	double error, lam, sum, adj, mean, herror, total;
+	int s, i, j;
 
-	/* Loop over hidden nodes */
-	for (i = 0; i < learn->num_hidden + 1; i++)
+	/* Grow batch arrays if needed */
+	if (num > learn->batch_max)
+	{
+		/* Remember new size */
+		learn->batch_max = num;
+
+		/* Reallocate arrays */
+		learn->batch_hidden = (double *)realloc(learn->batch_hidden,
+		                      sizeof(double) * num * (hidden + 1));
+		learn->batch_corr = (double *)realloc(learn->batch_corr,
+		                    sizeof(double) * num * hidden);
+		learn->batch_prob = (double *)realloc(learn->batch_prob,
+		                    sizeof(double) * num * output);
+		learn->batch_error = (double *)realloc(learn->batch_error,
+		                     sizeof(double) * num * output);
+	}
+
+	/* Clear hidden sums */
+	memset(learn->batch_hidden, 0, sizeof(double) * num * (hidden + 1));
+
+	/* Loop over inputs (each weight row is used for the whole batch) */
+	for (i = 0; i < learn->num_inputs + 1; i++)
+	{
+		/* Get weight row */
+		row = learn->hidden_weight[i];
+
+		/* Loop over input sets */
+		for (s = 0; s < num; s++)
+		{
+			/* Skip zero inputs */
+			if (!input[s][i]) continue;
+
+			/* Get hidden sums of input set */
+			hid = learn->batch_hidden + s * (hidden + 1);
+
+			/* Add weighted input to each sum */
+			for (j = 0; j < hidden; j++)
+			{
+				/* Adjust sum */
+				hid[j] += input[s][i] * row[j];
+			}
+		}
+	}
+
+	/* Loop over input sets */
+	for (s = 0; s < num; s++)
 	{
+		/* Get arrays for this input set */
+		hid = learn->batch_hidden + s * (hidden + 1);
+		corr = learn->batch_corr + s * hidden;
+		prob = learn->batch_prob + s * output;
+		err = learn->batch_error + s * output;
+
+		/* Normalize hidden node results */
+		for (j = 0; j < hidden; j++) hid[j] = sigmoid(hid[j]);
+
+		/* Bias node */
+		hid[hidden] = 1.0;
+
+		/* Clear output sums */
+		for (i = 0; i < output; i++) prob[i] = 0.0;
+
+		/* Compute output sums one weight row at a time */
+		for (j = 0; j < hidden + 1; j++)
+		{
+			/* Get weight row */
+			row = learn->output_weight[j];
+
+			/* Add weighted hidden result to each sum */
+			for (i = 0; i < output; i++) prob[i] += hid[j] * row[i];
+		}
+
+		/* Outputs are relative to first node */
+		adj = -prob[0];
+
+		/* Compute output results */
+		for (i = 0, sum = 0.0; i < output; i++)
+		{
+			/* Compute output result */
+			prob[i] = exp(prob[i] + adj);
+
+			/* Track total output */
+			sum += prob[i];
+		}
+
+		/* Compute output probabilities */
+		for (i = 0; i < output; i++) prob[i] /= sum;
+
+		/* Get weight of input set */
+		lam = lambda ? lambda[s] : 1.0;
+
+		/* Count error events */
+		learn->num_error += lam;
+
 		/* Loop over output nodes */
-		for (j = 0; j < learn->num_output; j++)
+		for (i = 0, total = 0.0; i < output; i++)
 		{
-			/* Apply training */
-			learn->output_weight[i][j] += learn->output_delta[i][j];
+			/* Compute error */
+			error = lam * (prob[i] - desired[s][i]);
 
-			/* Clear delta */
-			learn->output_delta[i][j] = 0;
+			/* Accumulate squared error */
+			learn->error += error * error;
+
+			/* Store error scaled by probability */
+			err[i] = error * prob[i];
+
+			/* Track total scaled error */
+			total += err[i];
+		}
+
+		/* Loop over hidden nodes (and bias) */
+		for (j = 0; j < hidden + 1; j++)
+		{
+			/* Get weight and delta rows */
+			row = learn->output_weight[j];
+			delta = learn->output_delta[j];
+
+			/* Start sums at zero */
+			mean = herror = 0.0;
+
+			/* Loop over output nodes */
+			for (i = 0; i < output; i++)
+			{
+				/* Probability-weighted mean of node's weights */
+				mean += prob[i] * row[i];
+
+				/* Error-weighted sum of node's weights */
+				herror += err[i] * row[i];
+
+				/* Apply correction */
+				delta[i] -= learn->alpha * hid[j] * err[i] *
+				            (1.0 - prob[i]);
+			}
+
+			/* Bias node has no hidden error */
+			if (j == hidden) break;
+
+			/*
+			 * Hidden node's error through the softmax Jacobian:
+			 *
+			 * sum_i err_i * p_i * (w_i - sum_k p_k * w_k)
+			 */
+			herror -= mean * total;
+
+			/* Calculate correction factor */
+			corr[j] = (1 - hid[j] * hid[j]) * -herror * learn->alpha;
 		}
 	}
 
-	/* Loop over input values */
+	/* Loop over inputs */
 	for (i = 0; i < learn->num_inputs + 1; i++)
 	{
-		/* Loop over hidden nodes */
-		for (j = 0; j < learn->num_hidden; j++)
+		/* Get delta row */
+		delta = learn->hidden_delta[i];
+
+		/* Loop over input sets */
+		for (s = 0; s < num; s++)
 		{
-			/* Apply training */
-			learn->hidden_weight[i][j] += learn->hidden_delta[i][j];
+			/* Skip zero inputs */
+			if (!input[s][i]) continue;
 
-			/* Clear delta */
-			learn->hidden_delta[i][j] = 0;
+			/* Get correction factors of input set */
+			corr = learn->batch_corr + s * hidden;
+
+			/* Loop over hidden nodes */
+			for (j = 0; j < hidden; j++)
+			{
+				/* Adjust weight */
+				delta[j] += corr[j] * input[s][i];
+			}
 		}
 	}
+
+	/* Clear stored sums and previous inputs */
+	clear_slots(learn);
+}
+
+/*
+ * Apply accumulated training information.
+ */
+void apply_training(net *learn)
+{
+	double *weight, *delta;
+	int i, n;
+
+	/* Get output weights and deltas */
+	weight = learn->output_weight[0];
+	delta = learn->output_delta[0];
+
+	/* Count output weights */
+	n = (learn->num_hidden + 1) * learn->num_output;
+
+	/* Loop over output weights */
+	for (i = 0; i < n; i++)
+	{
+		/* Apply training */
+		weight[i] += delta[i];
+
+		/* Clear delta */
+		delta[i] = 0;
+	}
+
+	/* Get hidden weights and deltas */
+	weight = learn->hidden_weight[0];
+	delta = learn->hidden_delta[0];
+
+	/* Count hidden weights */
+	n = (learn->num_inputs + 1) * learn->num_hidden;
+
+	/* Loop over hidden weights */
+	for (i = 0; i < n; i++)
+	{
+		/* Apply training */
+		weight[i] += delta[i];
+
+		/* Clear delta */
+		delta[i] = 0;
+	}
 }
 
 /*
@@ -522,39 +950,48 @@ void free_net(net *learn)
 
 	/* Free simple arrays */
 	free(learn->input_value);
-	free(learn->prev_input);
-	free(learn->hidden_sum);
 	free(learn->hidden_result);
 	free(learn->hidden_error);
+	free(learn->hidden_corr);
 	free(learn->net_result);
 	free(learn->win_prob);
 
-	/* Free rows of hidden weights */
-	for (i = 0; i < learn->num_inputs + 1; i++)
+	/* Free weights and deltas */
+	free_matrix(learn->hidden_weight);
+	free_matrix(learn->hidden_delta);
+	free_matrix(learn->output_weight);
+	free_matrix(learn->output_delta);
+
+	/* Free accumulator slots */
+	for (i = 0; i < learn->num_slot; i++)
 	{
-		/* Free weight row */
-		free(learn->hidden_weight[i]);
-		free(learn->hidden_delta[i]);
+		/* Free sums and previous inputs */
+		free(learn->slot_sum[i]);
+		free(learn->slot_prev[i]);
 	}
 
-	/* Free list of rows */
-	free(learn->hidden_weight);
-	free(learn->hidden_delta);
+	/* Free arrays of slots */
+	free(learn->slot_sum);
+	free(learn->slot_prev);
 
-	/* Free rows of output weights */
-	for (i = 0; i < learn->num_hidden + 1; i++)
-	{
-		/* Free weight row */
-		free(learn->output_weight[i]);
-		free(learn->output_delta[i]);
-	}
+	/* Free pushed states and change log */
+	free(learn->push_sum);
+	free(learn->push_slot);
+	free(learn->push_mark);
+	free(learn->change);
 
-	/* Free list of rows */
-	free(learn->output_weight);
-	free(learn->output_delta);
+	/* Free batch arrays */
+	free(learn->batch_hidden);
+	free(learn->batch_corr);
+	free(learn->batch_prob);
+	free(learn->batch_error);
 
-	/* Clear old past input sets */
-	clear_store(learn);
+	/* Free past input sets */
+	for (i = 0; i < PAST_MAX; i++)
+	{
+		/* Free input set */
+		free(learn->past_input[i]);
+	}
 
 	/* Free list of past inputs */
 	free(learn->past_input);
@@ -664,6 +1101,9 @@ void save_net(net *learn, char *fname)
 	/* Open output file */
 	fff = fopen(fname, "w");
 
+	/* Check for failure */
+	if (!fff) return;
+
 	/* Save network size */
 	fprintf(fff, "%d %d %d\n", learn->num_inputs, learn->num_hidden,
 	                           learn->num_output);
@@ -23,6 +23,28 @@
 #include <string.h>
 #include <math.h>
 
+/*
+ * Maximum number of previous input sets.
+ */
+#define PAST_MAX 120
+
+/*
+ * A change to an accumulator slot's previous inputs, logged while
+ * accumulator states are pushed.
+ */
+typedef struct net_change
+{
+	/* Previous input array of slot */
+	double *prev;
+
+	/* Input changed */
+	int index;
+
+	/* Value before change */
+	double value;
+
+} net_change;
+
 /*
  * A two-layer neural net.
  */
@@ -46,30 +68,59 @@ typedef struct net
 	/* Number of output nodes */
 	int num_output;
 
-	/* Hidden layer weights */
+	/* Hidden layer weights (rows of one contiguous block) */
 	double **hidden_weight;
 
 	/* Accumulated deltas to hidden weights */
 	double **hidden_delta;
 
-	/* Output layer weights */
+	/* Output layer weights (rows of one contiguous block) */
 	double **output_weight;
 
 	/* Accumulated deltas to output weights */
 	double **output_delta;
 
-	/* Hidden node sums */
+	/* Hidden node sums (of current accumulator slot) */
 	double *hidden_sum;
 
 	/* Cumulative hidden node error */
 	double *hidden_error;
 
+	/* Hidden weight correction factors (scratch space for training) */
+	double *hidden_corr;
+
 	/* Set of input values */
 	double *input_value;
 
-	/* Previous input values */
+	/* Previous input values (of current accumulator slot) */
 	double *prev_input;
 
+	/* Hidden node sums and previous inputs of each accumulator slot */
+	double **slot_sum;
+	double **slot_prev;
+
+	/* Number of accumulator slots */
+	int num_slot;
+
+	/* Current accumulator slot */
+	int cur_slot;
+
+	/* Saved hidden sums, slot and change log size of pushed states */
+	double *push_sum;
+	int *push_slot;
+	int *push_mark;
+
+	/* Number of pushed states, and number there is room for */
+	int num_push;
+	int max_push;
+
+	/* Log of previous input changes while states are pushed */
+	net_change *change;
+
+	/* Number of logged changes, and number there is room for */
+	int num_change;
+	int max_change;
+
 	/* Set of hidden results */
 	double *hidden_result;
 
@@ -82,29 +133,55 @@ typedef struct net
 	/* Sum that we divide results by to get probablities */
 	double prob_sum;
 
-	/* Sets of past inputs */
+	/* Sets of past inputs (ring buffer of PAST_MAX sets) */
 	double **past_input;
 
 	/* Player who created past inputs */
 	int *past_input_player;
 
+	/* Ring buffer position of oldest past input set */
+	int past_first;
+
 	/* Number of past input sets available */
 	int num_past;
 
 	/* Training iterations this network has gone through */
 	int num_training;
 
+	/* Hidden results, corrections, outputs and errors of a batch */
+	double *batch_hidden;
+	double *batch_corr;
+	double *batch_prob;
+	double *batch_error;
+
+	/* Number of samples the batch arrays have room for */
+	int batch_max;
+
 	/* Names of inputs */
 	char **input_name;
 
 } net;
 
+/*
+ * Ring buffer position of the given past input set (0 is oldest).
+ */
+#define PAST_INDEX(learn, i) (((learn)->past_first + (i)) % PAST_MAX)
+
+/* External variables */
+extern long net_num_computes;
+
 /* External functions */
 extern void make_learner(net *learn, int inputs, int hidden, int output);
 extern void compute_net(net *learn);
+extern void make_net_slots(net *learn, int num);
+extern void use_net_slot(net *learn, int slot);
+extern void push_net(net *learn);
+extern void pop_net(net *learn);
 extern void store_net(net *learn, int who);
 extern void clear_store(net *learn);
 extern void train_net(net *learn, double lambda, double *desired);
+extern void train_net_batch(net *learn, int num, double **input,
+                            double *lambda, double **desired);
 extern void apply_training(net *learn);
 extern void free_net(net *learn);
 extern int load_net(net *learn, char *fname);
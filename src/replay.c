@@ -21,10 +21,19 @@
 #include "rftg.h"
 #include "comm.h"
 #include <mysql/mysql.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <sys/wait.h>
 
 /* Number of random bytes stored per game */
 #define MAX_RAND     1024
 
+/* Number of games whose seeds and choices are fetched at once */
+#define PREFETCH_GAMES 64
+
+/* Maximum number of failed games to list in summary */
+#define MAX_FAILED   100
+
 /* The gid to start at */
 static int gid_min = -1;
 
@@ -43,21 +52,72 @@ static char* export_style_sheet = NULL;
 /* Export file style sheet */
 static char* export_style_sheet_replay = NULL;
 
+/* Write replay exports as one file per game */
+static int replay_per_game = 0;
+
 /* Verbosity */
 static int verbose = 0;
 
+/* Number of worker processes */
+static int num_workers = 1;
+
+/* Worker number of this process */
+static int worker = 0;
+
+/* Game archive to add replayed games to */
+static char *archive_name = NULL;
+
+/* First argument that is a file to convert to the archive */
+static int convert_first = 0;
+
+/* Database connection parameters */
+static char *db = "rftg";
+static char *db_user = "rftg";
+static char *db_pw = NULL, *db_host = NULL;
+
 /* Connection to the database server */
 MYSQL *mysql;
 
+/*
+ * Seed and choice logs of one game, fetched in advance.
+ */
+typedef struct prefetch
+{
+	/* Game ID */
+	int gid;
+
+	/* Whether random pool was found */
+	int have_pool;
+
+	/* Pool of random bytes */
+	unsigned char pool[MAX_RAND];
+
+	/* Number of choice logs found */
+	int num_logs;
+
+	/* User ID of each choice log */
+	int uid[MAX_PLAYER];
+
+	/* Choice logs */
+	int *log[MAX_PLAYER];
+
+	/* Length of each choice log in bytes */
+	unsigned long log_len[MAX_PLAYER];
+
+} prefetch;
+
+/* Games fetched in advance */
+static prefetch batch[PREFETCH_GAMES];
+
+/* First and last gid of games fetched in advance */
+static int batch_first = -1, batch_last = -1;
+
 /* The current replaying gid */
 static int gid;
 
 /* Game to be replayed */
 static game g;
 
-/* Current replay pass */
-static int pass;
-
 /* Current game round */
 static int current_round;
 
@@ -88,6 +148,74 @@ static int rotations;
 /* Set if any errors occurred */
 static int error = 0;
 
+/*
+ * Sections of a captured export.
+ *
+ * The status comes first, then each player in export order, then the
+ * log messages since the player's previous decision.
+ */
+#define SECTION_STATUS 0
+#define SECTION_PLAYER 1
+#define MAX_SECTION    (MAX_PLAYER + 2)
+
+/*
+ * An export of the game captured at one decision.
+ */
+typedef struct capture
+{
+	/* Text of each export section */
+	char *text[MAX_SECTION];
+
+	/* Whether section is unchanged since player's previous capture */
+	int8_t same[MAX_SECTION];
+
+	/* Player seat at time of capture */
+	int who;
+
+	/* Player name */
+	char *name;
+
+	/* Original player seat */
+	int orig_who;
+
+	/* Number of decisions made by player */
+	int choice;
+
+	/* Whether game was over */
+	int game_over;
+
+} capture;
+
+/* Exports captured while replaying the current game */
+static capture *captures;
+
+/* Number of captured exports */
+static int num_captures;
+
+/* Size of captured export array */
+static int capture_size;
+
+/* Previous capture of each original player */
+static int last_capture[MAX_PLAYER];
+
+/* Number of games replayed */
+static int num_replayed;
+
+/* Games that could not be replayed */
+static int failed[MAX_FAILED];
+
+/* Number of games that could not be replayed */
+static int num_failed;
+
+/* Current game could not be replayed or exported */
+static int game_failed;
+
+/* Place to return to when the current game cannot be replayed */
+static jmp_buf replay_abort;
+
+/* A game is being replayed, so errors abandon it */
+static int replaying;
+
 /* Player spots have been rotated */
 static void replay_notify_rotation(game *g, int who)
 {
@@ -312,10 +440,29 @@ static char *replay_file_name(int gid, int who, int choice)
 	return filename;
 }
 
+/* The link to the replay of a given player and choice */
+static char *replay_link(int who, int choice)
+{
+	static char link[1024];
+
+	/* Check for one file per game */
+	if (replay_per_game)
+	{
+		/* Format the anchor of the decision */
+		sprintf(link, "#p%d_d%d", who, choice);
+
+		/* Return the anchor */
+		return link;
+	}
+
+	/* Return the replay file name */
+	return replay_file_name(gid, who, choice);
+}
+
 /*
- * Export callback for generating player name links.
+ * Write the links to the full game and to each round of each player.
  */
-static void export_callback(FILE *fff, int orig_who)
+static void write_game_links(FILE *fff)
 {
 	int i, j;
 
@@ -337,41 +484,47 @@ static void export_callback(FILE *fff, int orig_who)
 
 		/* Print link to start of game for this player */
 		fprintf(fff, "    <Link text=\"Start\">%s</Link>\n",
-		        replay_file_name(gid, i, decision_round[i][0]));
+		        replay_link(i, decision_round[i][0]));
 
 		/* Loop over rounds */
 		for (j = 1; j <= num_rounds; ++j)
 		{
 			/* Print link to this round for this player */
 			fprintf(fff, "    <Link text=\"%d\">%s</Link>\n",
-			        j, replay_file_name(gid, i, decision_round[i][j]));
+			        j, replay_link(i, decision_round[i][j]));
 		}
 
 		/* Print link to end of game for this player */
 		fprintf(fff, "    <Link text=\"End\">%s</Link>\n",
-		        replay_file_name(gid, i, decision_round[i][num_rounds + 1]));
+		        replay_link(i, decision_round[i][num_rounds + 1]));
 
 		/* Write end tag */
 		fputs("  </Links>\n", fff);
 	}
+}
 
+/*
+ * Write the links to the previous and next choice of a captured export.
+ */
+static void write_navigation(FILE *fff, capture *c_ptr)
+{
 	/* Write start tag */
 	fputs("  <Links text=\"Navigate\">\n", fff);
 
 	/* Check for previous choice available */
-	if (num_choices[orig_who] > 0)
+	if (c_ptr->choice > 0)
 	{
 		/* Export previous choices */
 		fprintf(fff, "    <Link text=\"Previous choice\">%s</Link>\n",
-		        replay_file_name(gid, orig_who, num_choices[orig_who] - 1));
+		        replay_link(c_ptr->orig_who, c_ptr->choice - 1));
 	}
 
 	/* Check for next choice available */
-	if (!g.game_over)
+	if (!c_ptr->game_over)
 	{
 		/* Export next choices */
 		fprintf(fff, "    <Link text=\"Next choice\">%s</Link>\n",
-		        replay_file_name(gid, orig_who, num_choices[orig_who] + 1));
+		        replay_link(c_ptr->orig_who, c_ptr->choice + 1));
 	}
 
 	/* Write end tag */
@@ -391,9 +544,20 @@ static void export_end_callback(FILE *fff, int dummy)
 	/* Loop over players */
 	for (i = 0; i < g.num_players; ++i)
 	{
-		/* Print link to start of game for this player */
-		fprintf(fff, "    <Link text=\"%s\">replay/%s</Link>\n",
-		        g.p[new_id(i)].name, replay_file_name(gid, i, 0));
+		/* Check for one file per game */
+		if (replay_per_game)
+		{
+			/* Print link to start of game for this player */
+			fprintf(fff, "    <Link text=\"%s\">replay/Game_%06d.xml%s"
+			        "</Link>\n", g.p[new_id(i)].name, gid,
+			        replay_link(i, 0));
+		}
+		else
+		{
+			/* Print link to start of game for this player */
+			fprintf(fff, "    <Link text=\"%s\">replay/%s</Link>\n",
+			        g.p[new_id(i)].name, replay_link(i, 0));
+		}
 	}
 
 	/* Write end tag */
@@ -409,38 +573,348 @@ static int num_special_cards;
 /* The current special cards in an export */
 static card *special_cards[20];
 
-/* Export the game seen from a specific player */
+/*
+ * Capture an export of the game seen from a specific player.
+ *
+ * Each section of the export is rendered separately.  A section that is
+ * unchanged since the player's previous capture shares that capture's
+ * text, so only the changes are kept for each decision.
+ */
 static void export(game *g, int who)
 {
-	int orig_who;
-	char filename[1024];
+	capture *c_ptr, *prev_ptr = NULL;
+	FILE *fff;
+	size_t len;
+	int i, num_sections;
 
 	/* Check for replay style sheet enabled */
 	if (!export_style_sheet_replay) return;
 
+	/* Check for full capture array */
+	if (num_captures == capture_size)
+	{
+		/* Resize array */
+		capture_size += 256;
+
+		/* Reallocate */
+		captures = (capture *)realloc(captures,
+		                              sizeof(capture) * capture_size);
+	}
+
+	/* Get capture pointer */
+	c_ptr = &captures[num_captures];
+
+	/* Remember player seat and name */
+	c_ptr->who = who;
+	c_ptr->name = g->p[who].name;
+
 	/* Compute the original player seat */
-	orig_who = original_id(who);
+	c_ptr->orig_who = original_id(who);
+
+	/* Remember decision number */
+	c_ptr->choice = num_choices[c_ptr->orig_who];
+
+	/* Remember whether game is over */
+	c_ptr->game_over = g->game_over;
+
+	/* Check for previous capture for this player */
+	if (last_capture[c_ptr->orig_who] >= 0)
+	{
+		/* Get previous capture */
+		prev_ptr = &captures[last_capture[c_ptr->orig_who]];
+	}
+
+	/* Status, players and log */
+	num_sections = g->num_players + 2;
+
+	/* Score game to get end totals */
+	score_game(g);
+
+	/* Loop over sections */
+	for (i = 0; i < num_sections; i++)
+	{
+		/* Open memory buffer for section */
+		fff = open_memstream(&c_ptr->text[i], &len);
+
+		/* Check for failure */
+		if (!fff)
+		{
+			/* Log error */
+			printf("Could not capture game export\n");
+
+			/* Save error */
+			game_failed = 1;
+
+			/* Free sections captured so far */
+			for (i--; i >= 0; i--)
+			{
+				/* Free text not shared with previous capture */
+				if (!c_ptr->same[i]) free(c_ptr->text[i]);
+			}
+
+			/* Give up on this capture */
+			return;
+		}
+
+		/* Check for status section */
+		if (i == SECTION_STATUS)
+		{
+			/* Write status */
+			write_export_status(g, fff, msg);
+		}
+
+		/* Check for log section */
+		else if (i == num_sections - 1)
+		{
+			/* Write log start tag */
+			fputs("  <Log>\n", fff);
+
+			/* Write log */
+			export_log(fff, c_ptr->orig_who);
+
+			/* Write log end tag */
+			fputs("  </Log>\n", fff);
+		}
+
+		/* Player section */
+		else
+		{
+			/* Write player (in order following this player) */
+			write_export_player(g, fff,
+			                    (who + 1 + i - SECTION_PLAYER) %
+			                    g->num_players, who, num_special_cards,
+			                    special_cards);
+		}
+
+		/* Close buffer */
+		fclose(fff);
+
+		/* Assume section has changed */
+		c_ptr->same[i] = 0;
+
+		/* Log section only holds new messages, so is never the same */
+		if (i == num_sections - 1) continue;
+
+		/* Check for section unchanged since previous capture */
+		if (prev_ptr && !strcmp(prev_ptr->text[i], c_ptr->text[i]))
+		{
+			/* Share previous text */
+			free(c_ptr->text[i]);
+			c_ptr->text[i] = prev_ptr->text[i];
+			c_ptr->same[i] = 1;
+		}
+	}
+
+	/* Remember latest capture for this player */
+	last_capture[c_ptr->orig_who] = num_captures;
+
+	/* One more capture */
+	num_captures++;
+}
+
+/*
+ * Write one replay file for each captured export.
+ */
+static void write_capture_files(void)
+{
+	capture *c_ptr;
+	FILE *fff;
+	char filename[1024];
+	int i, j;
+
+	/* Loop over captured exports */
+	for (i = 0; i < num_captures; i++)
+	{
+		/* Get capture pointer */
+		c_ptr = &captures[i];
+
+		/* Create file name */
+		sprintf(filename, "%s/replay/%s", export_folder,
+		        replay_file_name(gid, c_ptr->orig_who, c_ptr->choice));
+
+		/* Open file for writing */
+		fff = fopen(filename, "w");
+
+		/* Check for failure */
+		if (!fff)
+		{
+			/* Log error */
+			printf("Could not export game to %s\n", filename);
+
+			/* Save error */
+			game_failed = 1;
+			continue;
+		}
+
+		/* Write header */
+		write_export_start(fff, export_style_sheet_replay, "RftgExport",
+		                   server_name);
+
+		/* Write player name */
+		fprintf(fff, "  <PlayerName>%s</PlayerName>\n",
+		        xml_escape(c_ptr->name));
+
+		/* Write setup */
+		write_export_setup(&g, fff);
+
+		/* Loop over sections */
+		for (j = 0; j < g.num_players + 2; j++)
+		{
+			/* Write section */
+			fputs(c_ptr->text[j], fff);
+		}
+
+		/* Write links */
+		write_game_links(fff);
+		write_navigation(fff, c_ptr);
+
+		/* End top level tag */
+		fputs("</RftgExport>\n", fff);
+
+		/* Close file */
+		fclose(fff);
+
+		/* Log export location */
+		if (verbose) printf("Game exported to %s\n", filename);
+	}
+}
+
+/*
+ * Write all captured exports to one replay file for the game.
+ *
+ * Each decision is written with only the sections that changed since the
+ * same player's previous decision.  Unchanged players are written as
+ * references, which the replay style sheet resolves.
+ */
+static void write_capture_game(void)
+{
+	capture *c_ptr;
+	FILE *fff;
+	char filename[1024];
+	int i, j;
 
 	/* Create file name */
-	sprintf(filename, "%s/replay/%s", export_folder,
-	        replay_file_name(gid, orig_who, num_choices[orig_who]));
+	sprintf(filename, "%s/replay/Game_%06d.xml", export_folder, gid);
 
-	/* Export game to file */
-	if (export_game(g, filename, export_style_sheet_replay, server_name,
-	    who, msg, num_special_cards, special_cards, 0,
-	    export_log, export_callback, orig_who) < 0)
+	/* Open file for writing */
+	fff = fopen(filename, "w");
+
+	/* Check for failure */
+	if (!fff)
 	{
 		/* Log error */
 		printf("Could not export game to %s\n", filename);
 
 		/* Save error */
-		error = 1;
+		game_failed = 1;
+		return;
+	}
+
+	/* Write header */
+	write_export_start(fff, export_style_sheet_replay, "RftgReplay",
+	                   server_name);
+
+	/* Write setup */
+	write_export_setup(&g, fff);
+
+	/* Write links */
+	write_game_links(fff);
+
+	/* Loop over captured exports */
+	for (i = 0; i < num_captures; i++)
+	{
+		/* Get capture pointer */
+		c_ptr = &captures[i];
+
+		/* Write decision start tag */
+		fprintf(fff, "  <Decision id=\"p%d_d%d\" player=\"%d\">\n",
+		        c_ptr->orig_who, c_ptr->choice, c_ptr->orig_who);
+
+		/* Write player name */
+		fprintf(fff, "  <PlayerName>%s</PlayerName>\n",
+		        xml_escape(c_ptr->name));
+
+		/* Write navigation links */
+		write_navigation(fff, c_ptr);
+
+		/* Loop over sections */
+		for (j = 0; j < g.num_players + 2; j++)
+		{
+			/* Check for changed section */
+			if (!c_ptr->same[j])
+			{
+				/* Write section */
+				fputs(c_ptr->text[j], fff);
+			}
+
+			/* Check for unchanged status */
+			else if (j == SECTION_STATUS)
+			{
+				/* Write reference */
+				fputs("  <Status same=\"yes\" />\n", fff);
+			}
+
+			/* Unchanged player */
+			else
+			{
+				/* Write reference */
+				fprintf(fff, "  <Player id=\"%d\" same=\"yes\" />\n",
+				        (c_ptr->who + 1 + j - SECTION_PLAYER) %
+				        g.num_players);
+			}
+		}
+
+		/* Write decision end tag */
+		fputs("  </Decision>\n", fff);
+	}
+
+	/* End top level tag */
+	fputs("</RftgReplay>\n", fff);
+
+	/* Close file */
+	fclose(fff);
+
+	/* Log export location */
+	if (verbose) printf("Game exported to %s\n", filename);
+}
+
+/* Forget captured exports */
+static void free_captures(void)
+{
+	int i, j;
+
+	/* Loop over captured exports */
+	for (i = 0; i < num_captures; i++)
+	{
+		/* Loop over sections */
+		for (j = 0; j < g.num_players + 2; j++)
+		{
+			/* Free text not shared with previous capture */
+			if (!captures[i].same[j]) free(captures[i].text[j]);
+		}
+	}
+
+	/* Clear captures */
+	num_captures = 0;
+}
+
+/* Write captured exports to replay files */
+static void write_captures(void)
+{
+	/* Check for one file per game */
+	if (replay_per_game)
+	{
+		/* Write game file */
+		write_capture_game();
 	}
 	else
 	{
-		/* Log export location */
-		if (verbose) printf("Game exported to %s\n", filename);
+		/* Write file per decision */
+		write_capture_files();
 	}
+
+	/* Free captures */
+	free_captures();
 }
 
 /* Export the complete game */
@@ -465,7 +939,7 @@ static void export_end(game *g)
 		printf("Could not export game to %s\n", filename);
 
 		/* Save error */
-		error = 1;
+		game_failed = 1;
 	}
 	else
 	{
@@ -795,7 +1269,7 @@ static void replay_make_choice(game *g, int who, int type, int list[], int *nl,
 	orig_who = original_id(who);
 
 	/* Check for new round */
-	if (pass == 1 && who == 0 && g->round != current_round)
+	if (who == 0 && g->round != current_round)
 	{
 		/* Update round */
 		current_round = g->round;
@@ -808,8 +1282,8 @@ static void replay_make_choice(game *g, int who, int type, int list[], int *nl,
 		}
 	}
 
-	/* Check for second pass */
-	if (pass == 2)
+	/* Check for replay exports */
+	if (export_style_sheet_replay)
 	{
 		/* Find message */
 		determine_message(g, who, type, list, nl, special, ns, arg1, arg2, arg3);
@@ -824,6 +1298,14 @@ static void replay_make_choice(game *g, int who, int type, int list[], int *nl,
 	/* Read the current choice position */
 	current = g->p[who].choice_pos;
 
+	/* Check for no more choices logged */
+	if (current >= choice_size[orig_who])
+	{
+		/* Error */
+		display_error("Game ran out of logged choices!\n");
+		exit(1);
+	}
+
 	/* Set next position */
 	next = current;
 
@@ -919,6 +1401,114 @@ static void db_user_name(int uid, char *name)
 	mysql_free_result(res);
 }
 
+/*
+ * Fetch seeds and choice logs for the next batch of games handled by
+ * this worker, starting at the given game.
+ */
+static void db_prefetch_games(int first)
+{
+	MYSQL_RES *res;
+	MYSQL_ROW row;
+	prefetch *f_ptr;
+	unsigned long *field_len;
+	char query[1024];
+	int i, k;
+
+	/* Set range of games in batch */
+	batch_first = first;
+	batch_last = first + (PREFETCH_GAMES - 1) * num_workers;
+
+	/* Do not go past last game */
+	if (batch_last > gid_max) batch_last = gid_max;
+
+	/* Loop over games in batch */
+	for (i = 0; i < PREFETCH_GAMES; i++)
+	{
+		/* Get batch entry */
+		f_ptr = &batch[i];
+
+		/* Set game ID */
+		f_ptr->gid = first + i * num_workers;
+
+		/* Nothing found yet */
+		f_ptr->have_pool = 0;
+
+		/* Loop over old choice logs */
+		for (k = 0; k < f_ptr->num_logs; k++)
+		{
+			/* Free log */
+			free(f_ptr->log[k]);
+		}
+
+		/* No choice logs found yet */
+		f_ptr->num_logs = 0;
+	}
+
+	/* Create query */
+	sprintf(query, "SELECT gid, pool FROM seed WHERE gid BETWEEN %d AND %d \
+	                AND MOD(gid - %d, %d) = 0",
+	        batch_first, batch_last, batch_first, num_workers);
+
+	/* Run query */
+	mysql_query(mysql, query);
+
+	/* Fetch results */
+	res = mysql_store_result(mysql);
+
+	/* Loop over rows returned */
+	while (res && (row = mysql_fetch_row(res)))
+	{
+		/* Get batch entry */
+		f_ptr = &batch[(strtol(row[0], NULL, 0) - first) / num_workers];
+
+		/* Copy returned data to random byte pool */
+		memcpy(f_ptr->pool, row[1], MAX_RAND);
+
+		/* Mark pool as found */
+		f_ptr->have_pool = 1;
+	}
+
+	/* Free result */
+	if (res) mysql_free_result(res);
+
+	/* Create query */
+	sprintf(query, "SELECT gid, uid, log FROM choices \
+	                WHERE gid BETWEEN %d AND %d AND MOD(gid - %d, %d) = 0",
+	        batch_first, batch_last, batch_first, num_workers);
+
+	/* Run query */
+	mysql_query(mysql, query);
+
+	/* Fetch results */
+	res = mysql_store_result(mysql);
+
+	/* Loop over rows returned */
+	while (res && (row = mysql_fetch_row(res)))
+	{
+		/* Get batch entry */
+		f_ptr = &batch[(strtol(row[0], NULL, 0) - first) / num_workers];
+
+		/* Skip unexpected extra logs */
+		if (f_ptr->num_logs == MAX_PLAYER) continue;
+
+		/* Get length of log in bytes */
+		field_len = mysql_fetch_lengths(res);
+
+		/* Remember user */
+		f_ptr->uid[f_ptr->num_logs] = strtol(row[1], NULL, 0);
+
+		/* Copy log */
+		f_ptr->log[f_ptr->num_logs] = (int *)malloc(field_len[2]);
+		memcpy(f_ptr->log[f_ptr->num_logs], row[2], field_len[2]);
+
+		/* Remember length */
+		f_ptr->log_len[f_ptr->num_logs++] = field_len[2];
+	}
+
+	/* Free result */
+	if (res) mysql_free_result(res);
+}
+
 /*
  * Read game from database.
  */
@@ -926,8 +1516,8 @@ static int db_load_game(int gid)
 {
 	MYSQL_RES *res;
 	MYSQL_ROW row;
-	int i, players = 0, uids[MAX_PLAYER];
-	unsigned long *field_len;
+	prefetch *f_ptr;
+	int i, k, players = 0, uids[MAX_PLAYER];
 	char query[1024];
 	char name[80];
 
@@ -986,9 +1576,11 @@ static int db_load_game(int gid)
 		/* Set player interface function */
 		g.p[players].control = &replay_func;
 
-		/* Create choice log */
-		g.p[players].choice_log = (int *)malloc(sizeof(int) * 4096);
-		choice_logs[players] = (int *)malloc(sizeof(int) * 4096);
+		/* Create choice logs (if not already made) */
+		if (!g.p[players].choice_log)
+			g.p[players].choice_log = (int *)malloc(sizeof(int) * 4096);
+		if (!choice_logs[players])
+			choice_logs[players] = (int *)malloc(sizeof(int) * 4096);
 
 		/* Get player's name */
 		db_user_name(uids[players], name);
@@ -1016,67 +1608,48 @@ static int db_load_game(int gid)
 	/* Free results */
 	mysql_free_result(res);
 
-	/* Create query */
-	sprintf(query, "SELECT pool FROM seed WHERE gid=%d", gid);
+	/* Check for game not in prefetched batch */
+	if (gid < batch_first || gid > batch_last)
+	{
+		/* Fetch seeds and choices of next batch of games */
+		db_prefetch_games(gid);
+	}
 
-	/* Run query */
-	mysql_query(mysql, query);
+	/* Get prefetched game */
+	f_ptr = &batch[(gid - batch_first) / num_workers];
 
-	/* Fetch results */
-	res = mysql_store_result(mysql);
-
-	/* Check for no rows returned */
-	if (!(row = mysql_fetch_row(res)))
+	/* Check for no random pool */
+	if (!f_ptr->have_pool)
 	{
-		/* Free result */
-		mysql_free_result(res);
-
 		/* No pool to load */
 		printf("Could not load random pool\n");
 		return 0;
 	}
 
-	/* Copy returned data to random byte pool */
-	memcpy(random_pool, row[0], MAX_RAND);
-
-	/* Free result */
-	mysql_free_result(res);
+	/* Copy random byte pool */
+	memcpy(random_pool, f_ptr->pool, MAX_RAND);
 
 	/* Loop over players in session */
 	for (i = 0; i < players; i++)
 	{
-		/* TODO: Join with query above */
-		/* Create query to load choice log */
-		sprintf(query,"SELECT log FROM choices WHERE gid=%d AND uid=%d",
-		        gid, uids[i]);
-
-		/* Run query */
-		mysql_query(mysql, query);
+		/* Assume no choice log */
+		choice_size[i] = 0;
 
-		/* Fetch results */
-		res = mysql_store_result(mysql);
-
-		/* Check for no rows returned */
-		if (!(row = mysql_fetch_row(res)))
+		/* Look for player's choice log */
+		for (k = 0; k < f_ptr->num_logs; k++)
 		{
-			/* Free result */
-			mysql_free_result(res);
-
-			/* Go to next player */
-			continue;
+			/* Check for match */
+			if (f_ptr->uid[k] == uids[i]) break;
 		}
 
-		/* Get length of log in bytes */
-		field_len = mysql_fetch_lengths(res);
+		/* Check for no log found */
+		if (k == f_ptr->num_logs) continue;
 
 		/* Copy log */
-		memcpy(choice_logs[i], row[0], field_len[0]);
+		memcpy(choice_logs[i], f_ptr->log[k], f_ptr->log_len[k]);
 
 		/* Remember length */
-		choice_size[i] = field_len[0] / sizeof(int);
-
-		/* Free result */
-		mysql_free_result(res);
+		choice_size[i] = f_ptr->log_len[k] / sizeof(int);
 	}
 
 	/* Success */
@@ -1090,6 +1663,12 @@ void display_error(char *msg)
 {
 	/* Forward message */
 	printf("%s", msg);
+
+	/*
+	 * The engine aborts after errors such as a choice log that does
+	 * not match the game, so abandon the game being replayed instead.
+	 */
+	if (replaying) longjmp(replay_abort, 1);
 }
 
 /*
@@ -1132,7 +1711,7 @@ void replay_game()
 	int i;
 
 	/* Log message */
-	printf("Replaying game %d (Pass %d)\n", gid, pass);
+	printf("Replaying game %d\n", gid);
 
 	/* Initialize game */
 	init_game(&g);
@@ -1149,34 +1728,249 @@ void replay_game()
 	/* Declare winner */
 	declare_winner(&g);
 
-	/* Check for first pass */
-	if (pass == 1)
+	/* Store last round */
+	num_rounds = g.round;
+
+	/* Loop over players */
+	for (i = 0; i < g.num_players; ++i)
+	{
+		/* Store end decisions */
+		decision_round[i][num_rounds + 1] = num_choices[i];
+	}
+
+	/* Export full game */
+	export_end(&g);
+
+	/* Clear message */
+	strcpy(msg, "");
+
+	/* Loop over players */
+	for (i = 0; i < g.num_players; ++i)
+	{
+		/* Export the game */
+		export(&g, i);
+	}
+
+	/* Write replay exports now that navigation is known */
+	write_captures();
+}
+
+/*
+ * Connect to the database.
+ */
+static void db_connect(void)
+{
+	my_bool reconnect = 1;
+
+	/* Initialize database library */
+	mysql = mysql_init(NULL);
+
+	/* Check for error */
+	if (!mysql)
+	{
+		/* Print error and exit */
+		printf("Couldn't initialize database library!");
+		exit(1);
+	}
+
+	/* Attempt to connect to database server */
+	if (!mysql_real_connect(mysql, db_host, db_user, db_pw, db, 0, NULL, 0))
+	{
+		/* Print error and exit */
+		printf("Database connection: %s", mysql_error(mysql));
+		exit(1);
+	}
+
+	/* Reconnect automatically when connection to database is lost */
+	mysql_options(mysql, MYSQL_OPT_RECONNECT, &reconnect);
+}
+
+/*
+ * Add the game loaded from the database to the archive.
+ */
+static void archive_db_game(void)
+{
+	char filename[1024];
+	int i;
+
+	/* Loop over players */
+	for (i = 0; i < g.num_players; i++)
+	{
+		/* Copy choice log from database */
+		memcpy(g.p[i].choice_log, choice_logs[i],
+		       sizeof(int) * choice_size[i]);
+
+		/* Set size of choice log */
+		g.p[i].choice_unread_pos = choice_size[i];
+	}
+
+	/* No human player */
+	g.human_name = NULL;
+
+	/* Check for multiple workers */
+	if (num_workers > 1)
+	{
+		/* Use separate archive for each worker */
+		sprintf(filename, "%.1000s.%d", archive_name, worker);
+	}
+	else
+	{
+		/* Use archive name as given */
+		sprintf(filename, "%.1000s", archive_name);
+	}
+
+	/* Add game to archive */
+	if (archive_game(&g, filename, 0, random_pool, MAX_RAND) < 0)
+	{
+		/* Log error */
+		printf("Could not add game %d to %s\n", gid, filename);
+
+		/* Save error */
+		game_failed = 1;
+	}
+}
+
+/*
+ * Convert save or export files to the archive.
+ */
+static void convert_files(int argc, char *argv[])
+{
+	int i, j;
+
+	/* Loop over players */
+	for (j = 0; j < MAX_PLAYER; j++)
+	{
+		/* Create choice log */
+		g.p[j].choice_log = (int *)malloc(sizeof(int) * 4096);
+	}
+
+	/* Loop over files */
+	for (i = convert_first; i < argc; i++)
 	{
-		/* Store last round */
-		num_rounds = g.round;
+		/* Load game */
+		if (load_game(&g, argv[i]) < 0)
+		{
+			/* Log error */
+			printf("Could not load game from %s\n", argv[i]);
+
+			/* Save error */
+			error = 1;
+			continue;
+		}
 
 		/* Loop over players */
-		for (i = 0; i < g.num_players; ++i)
+		for (j = 0; j < g.num_players; j++)
 		{
-			/* Store end decisions */
-			decision_round[i][num_rounds + 1] = num_choices[i];
+			/* Entire choice log is used */
+			g.p[j].choice_unread_pos = g.p[j].choice_size;
 		}
 
-		/* Export full game */
-		export_end(&g);
+		/* Add game to archive */
+		if (archive_game(&g, archive_name, 0, NULL, 0) < 0)
+		{
+			/* Log error */
+			printf("Could not add %s to %s\n", argv[i], archive_name);
+
+			/* Save error */
+			error = 1;
+		}
 	}
-	else
+}
+
+/*
+ * Replay this worker's share of the games.
+ */
+static void replay_games(void)
+{
+	int i, j;
+
+	/* Loop over games handled by this worker */
+	for (i = gid_min + worker; i <= gid_max; i += num_workers)
 	{
-		/* Clear message */
-		strcpy(msg, "");
+		/* Set game */
+		gid = i;
+
+		/* Count game */
+		num_replayed++;
+
+		/* No errors in this game yet */
+		game_failed = 0;
+
+		/* Read game state from database */
+		if (!db_load_game(gid))
+		{
+			/* Remember failed game */
+			if (num_failed < MAX_FAILED) failed[num_failed] = gid;
+			num_failed++;
+			continue;
+		}
+
+		/* Add game to archive if wanted */
+		if (archive_name) archive_db_game();
+
+		/* Clear fields */
+		random_pos = 0;
+		current_round = 0;
+		rotations = 0;
+		num_messages = 0;
 
 		/* Loop over players */
-		for (i = 0; i < g.num_players; ++i)
+		for (j = 0; j < MAX_PLAYER; ++j)
+		{
+			/* Clear player fields */
+			num_choices[j] = 0;
+			decision_round[j][0] = 0;
+			log_pos[j] = 0;
+			last_capture[j] = -1;
+
+			/* Clear choice log size and position */
+			g.p[j].choice_size = 0;
+			g.p[j].choice_pos = 0;
+		}
+
+		/* Check for game that could not be replayed */
+		if (setjmp(replay_abort))
+		{
+			/* Discard exports of abandoned game */
+			free_captures();
+
+			/* Save error */
+			game_failed = 1;
+		}
+		else
 		{
-			/* Export the game */
-			export(&g, i);
+			/* Abandon game on errors */
+			replaying = 1;
+
+			/* Replay the game */
+			replay_game();
 		}
+
+		/* Game is no longer replayed */
+		replaying = 0;
+
+		/* Check for replay or export errors */
+		if (game_failed)
+		{
+			/* Remember failed game */
+			if (num_failed < MAX_FAILED) failed[num_failed] = gid;
+			num_failed++;
+		}
+	}
+
+	/* Print summary */
+	printf("Worker %d: %d games, %d failed\n", worker, num_replayed,
+	       num_failed);
+
+	/* Loop over failed games */
+	for (i = 0; i < num_failed && i < MAX_FAILED; i++)
+	{
+		/* Print game ID */
+		printf("Worker %d: game %d failed\n", worker, failed[i]);
 	}
+
+	/* Check for failures */
+	if (num_failed) error = 1;
 }
 
 /*
@@ -1184,11 +1978,7 @@ void replay_game()
  */
 int main(int argc, char *argv[])
 {
-	int i, j;
-	my_bool reconnect = 1;
-	char *db = "rftg";
-	char *db_user = "rftg";
-	char *db_pw = NULL, *db_host = NULL;
+	int i, status;
 	char buf[1024];
 
 	/* Parse arguments */
@@ -1210,6 +2000,13 @@ int main(int argc, char *argv[])
 			printf("  -s     Server name (to be used in exports). Default: [none]\n");
 			printf("  -ss    XSLT style sheets for exported complete games. Default: [none]\n");
 			printf("  -ssr   XSLT style sheets for exported replay games. Default: [none]\n");
+			printf("  -rg    Write replay exports as one file per game instead of\n"
+			       "         one file per decision. Default: false\n");
+			printf("  -j     Number of worker processes. Default: 1\n");
+			printf("  -a     Add replayed games to this game archive. With -j,\n"
+			       "         each worker adds \".N\" to the name. Default: [none]\n");
+			printf("  -x     Add the save or export files following -x to the\n"
+			       "         game archive given with -a, instead of replaying.\n");
 			printf("  -v     Verbose (print messages as they appear). Default: false.\n\n");
 			printf("  -h     Print this usage text and exit.\n\n");
 			printf("For more information, see the following web sites:\n");
@@ -1287,12 +2084,44 @@ int main(int argc, char *argv[])
 			export_style_sheet_replay = argv[++i];
 		}
 
+		/* Check for replay file per game */
+		if (!strcmp(argv[i], "-rg"))
+		{
+			/* Set one file per game */
+			replay_per_game = 1;
+		}
+
+		/* Check for number of workers */
+		if (!strcmp(argv[i], "-j"))
+		{
+			/* Set number of workers */
+			num_workers = atoi(argv[++i]);
+
+			/* Need at least one */
+			if (num_workers < 1) num_workers = 1;
+		}
+
+		/* Check for game archive */
+		if (!strcmp(argv[i], "-a"))
+		{
+			/* Set game archive */
+			archive_name = argv[++i];
+		}
+
 		/* Check for verbosity */
 		if (!strcmp(argv[i], "-v"))
 		{
 			/* Set verbosity */
 			verbose = 1;
 		}
+
+		/* Check for files to convert */
+		if (!strcmp(argv[i], "-x"))
+		{
+			/* Remaining arguments are files */
+			convert_first = i + 1;
+			break;
+		}
 	}
 
 	/* Make a copy of the program path */
@@ -1324,67 +2153,84 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	/* Initialize database library */
-	mysql = mysql_init(NULL);
-
-	/* Check for error */
-	if (!mysql)
+	/* Check for files to convert */
+	if (convert_first)
 	{
-		/* Print error and exit */
-		printf("Couldn't initialize database library!");
-		exit(1);
+		/* Check for no archive */
+		if (!archive_name)
+		{
+			/* Print error and exit */
+			printf("No game archive given (use -a)\n");
+			exit(1);
+		}
+
+		/* Convert files */
+		convert_files(argc, argv);
+
+		/* Return error value */
+		return error;
 	}
 
-	/* Attempt to connect to database server */
-	if (!mysql_real_connect(mysql, db_host, db_user, db_pw, db, 0, NULL, 0))
+	/* Check for single worker */
+	if (num_workers == 1)
 	{
-		/* Print error and exit */
-		printf("Database connection: %s", mysql_error(mysql));
-		exit(1);
+		/* Connect to database */
+		db_connect();
+
+		/* Replay all games */
+		replay_games();
+
+		/* Return error value */
+		return error;
 	}
 
-	/* Reconnect automatically when connection to database is lost */
-	mysql_options(mysql, MYSQL_OPT_RECONNECT, &reconnect);
+	/* Flush output before forking */
+	fflush(stdout);
 
-	/* Loop over all games */
-	for (i = gid_min; i <= gid_max; ++i)
+	/* Loop over workers */
+	for (i = 0; i < num_workers; i++)
 	{
-		/* Set game */
-		gid = i;
-
-		/* Run two passes */
-		for (pass = 1; pass <= 2; ++pass)
+		/* Fork a child process */
+		switch (fork())
 		{
-			/* Read game state from database */
-			if (!db_load_game(gid)) continue;
+			/* Error */
+			case -1:
 
-			/* Clear fields */
-			random_pos = 0;
-			current_round = 0;
-			rotations = 0;
-			num_messages = 0;
+				/* Print error */
+				perror("fork");
+				exit(1);
 
-			/* Loop over players */
-			for (j = 0; j < MAX_PLAYER; ++j)
-			{
-				/* Clear player fields */
-				num_choices[j] = 0;
-				decision_round[j][0] = 0;
-				log_pos[j] = 0;
-
-				/* Clear choice log size and position */
-				g.p[j].choice_size = 0;
-				g.p[j].choice_pos = 0;
-			}
+			/* Child */
+			case 0:
 
-			/* Replay the game */
-			replay_game();
+				/* Keep lines from workers separate */
+				setvbuf(stdout, NULL, _IOLBF, 0);
 
-			/* Check for only one pass needed */
-			if (!export_style_sheet_replay) break;
+				/* Set worker number */
+				worker = i;
+
+				/* Connect to database */
+				db_connect();
+
+				/* Replay our share of games */
+				replay_games();
+
+				/* Done */
+				exit(error);
 		}
 	}
 
+	/* Wait for workers to finish */
+	while (wait(&status) > 0)
+	{
+		/* Check for worker failure */
+		if (!WIFEXITED(status) || WEXITSTATUS(status)) error = 1;
+	}
+
+	/* Print summary */
+	printf("All workers finished%s\n",
+	       error ? ", some games failed" : "");
+
 	/* Return error value */
 	return error;
 }
@@ -46,6 +46,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #ifdef WIN32
 #include "stdint.h"
 #else
@@ -82,6 +83,11 @@
  */
 #define MAX_DECK 328
 
+/*
+ * Number of 64-bit words in a set of deck indices.
+ */
+#define DECK_WORDS ((MAX_DECK + 63) / 64)
+
 /*
  * Number of powers per card.
  */
@@ -109,6 +115,23 @@
 #define EXP_RVIO      6
 #define MAX_EXPANSION 7
 
+/*
+ * Features of each expansion.
+ *
+ * Each entry gives the expansion number, full and short names, display
+ * order, maximum players, and whether it has goals, takeovers, prestige
+ * and a choice of start world.  This table builds exp_info[], and also
+ * the constant feature checks used when FIXED_EXPANSION is defined.
+ */
+#define EXP_TABLE(X) \
+	X(EXP_BASE, "Base game only", "Base", 0, 4, 0, 0, 0, 0) \
+	X(EXP_TGS, "The Gathering Storm", "TGS", 1, 5, 1, 0, 0, 0) \
+	X(EXP_RVI, "Rebel vs Imperium", "RvI", 6, 6, 1, 1, 0, 1) \
+	X(EXP_BOW, "The Brink of War", "BoW", 2, 6, 1, 1, 1, 1) \
+	X(EXP_AA, "Alien Artifacts", "AA", 3, 5, 0, 0, 0, 1) \
+	X(EXP_XI, "Xeno Invasion", "XI", 4, 5, 0, 0, 0, 1) \
+	X(EXP_RVIO, "Rebel vs Imperium only", "RvIo", 5, 5, 0, 1, 0, 0)
+
 /*
  * Round phases.
  */
@@ -577,6 +600,7 @@
 #define CHOICE_SEARCH_TYPE      22
 #define CHOICE_SEARCH_KEEP      23
 #define CHOICE_OORT_KIND        24
+#define MAX_CHOICE              25
 
 /*
  * Debug choices are negative
@@ -709,6 +733,9 @@ typedef struct design
 
 /*
  * Information about an instance of a card.
+ *
+ * Fields read by list walks and location checks come first, ahead of
+ * the start-of-phase copies and the design pointer.
  */
 typedef struct card
 {
@@ -718,32 +745,35 @@ typedef struct card
 	/* Card's location */
 	int8_t where;
 
-	/* Card's owner at start of phase */
-	int8_t start_owner;
+	/* Number of goods placed on this card */
+	int8_t num_goods;
 
-	/* Card's location at start of phase */
-	int8_t start_where;
+	/* Order played on the table */
+	int8_t order;
 
 	/* Miscellaneous card flags */
 	uint16_t misc;
 
-	/* Card design */
-	design *d_ptr;
+	/* Next card index if belonging to player */
+	int16_t next;
+
+	/* Previous card index if belonging to player */
+	int16_t prev;
 
 	/* Card we are covering (if a good) */
 	int16_t covering;
 
-	/* Number of goods placed on this card */
-	int8_t num_goods;
+	/* Next card index as of start of phase (if list changed this phase) */
+	int16_t start_next;
 
-	/* Order played on the table */
-	int8_t order;
+	/* Card's owner at start of phase (if moved this phase) */
+	int8_t start_owner;
 
-	/* Next card index if belonging to player */
-	int16_t next;
+	/* Card's location at start of phase (if moved this phase) */
+	int8_t start_where;
 
-	/* Next card index as of start of phase */
-	int16_t start_next;
+	/* Card design */
+	design *d_ptr;
 
 } card;
 
@@ -849,6 +879,9 @@ typedef struct player
 	/* Player's first card of each location as of the start of the phase */
 	int16_t start_head[MAX_WHERE];
 
+	/* Locations whose list has changed since the start of the phase */
+	uint8_t start_saved;
+
 	/* Card chosen in Develop or Settle phase */
 	int16_t placing;
 
@@ -958,6 +991,12 @@ typedef struct game
 	/* Game is a simulation */
 	int8_t simulation;
 
+	/* Game messages are not generated (set when nobody reads them) */
+	int8_t silent;
+
+	/* Logged choices are being replayed without notifying players */
+	int8_t fast_forward;
+
 	/* Whether game is a debug game or not */
 	int8_t debug_game;
 
@@ -994,9 +1033,6 @@ typedef struct game
 	/* Size of deck in use */
 	int16_t deck_size;
 
-	/* Information about each card */
-	card deck[MAX_DECK];
-
 	/* Victory points remaining in the pool */
 	int8_t vp_pool;
 
@@ -1045,6 +1081,23 @@ typedef struct game
 	/* Game is over */
 	int8_t game_over;
 
+	/* Set of cards owned by each player */
+	uint64_t owner_set[MAX_PLAYER][DECK_WORDS];
+
+	/* Set of cards in each location (only cards owned by a player) */
+	uint64_t where_set[MAX_WHERE][DECK_WORDS];
+
+	/* Set of cards moved since the start of the phase */
+	uint64_t moved_set[DECK_WORDS];
+
+	/*
+	 * Information about each card.
+	 *
+	 * This must remain the last field, since only the first deck_size
+	 * entries are copied when the game state is duplicated.
+	 */
+	card deck[MAX_DECK];
+
 } game;
 
 /*
@@ -1119,16 +1172,80 @@ extern char *plain_actname[MAX_ACTION + 1];
 extern char *good_printable[MAX_GOOD];
 extern char *goal_name[MAX_GOAL];
 extern char *search_name[MAX_SEARCH];
+extern char *choice_name[MAX_CHOICE];
 extern char *player_labels[MAX_PLAYER];
 extern char *location_names[MAX_WHERE];
 extern decisions ai_func;
 extern decisions gui_func;
+extern long ai_num_alloc;
+extern long ai_cache_hit, ai_cache_miss;
+extern double ai_time_budget;
+extern int ai_max_networks;
+extern long ai_num_timeout;
+extern int (*ai_interrupt)(void);
+extern int ai_interrupted;
+extern void ai_print_profile(FILE *fff);
 
 /*
  * Macro functions.
  */
 #define PLURAL(x) ((x) == 1 ? "" : "s")
 
+/*
+ * Expansion being played, and the features it has.
+ *
+ * If FIXED_EXPANSION is defined to one of the EXP_ values at build time,
+ * only that expansion is supported, and these become constants so that
+ * code for other expansions is compiled out.
+ */
+#ifdef FIXED_EXPANSION
+#define FIXED_GOALS(x, name, abbr, order, max, goals, takeovers, prestige, \
+                    start) \
+	|| (FIXED_EXPANSION == (x) && (goals))
+#define FIXED_TAKEOVERS(x, name, abbr, order, max, goals, takeovers, \
+                        prestige, start) \
+	|| (FIXED_EXPANSION == (x) && (takeovers))
+#define FIXED_PRESTIGE(x, name, abbr, order, max, goals, takeovers, \
+                       prestige, start) \
+	|| (FIXED_EXPANSION == (x) && (prestige))
+#define GAME_EXP(g)      (FIXED_EXPANSION)
+#define HAS_GOALS(g)     (0 EXP_TABLE(FIXED_GOALS))
+#define HAS_TAKEOVERS(g) (0 EXP_TABLE(FIXED_TAKEOVERS))
+#define HAS_PRESTIGE(g)  (0 EXP_TABLE(FIXED_PRESTIGE))
+#else
+#define GAME_EXP(g)      ((g)->expanded)
+#define HAS_GOALS(g)     (exp_info[(g)->expanded].has_goals)
+#define HAS_TAKEOVERS(g) (exp_info[(g)->expanded].has_takeovers)
+#define HAS_PRESTIGE(g)  (exp_info[(g)->expanded].has_prestige)
+#endif
+
+/*
+ * Whether messages about the game should be generated.
+ *
+ * Simulated games, silent games and fast-forward replays skip formatting
+ * messages entirely.
+ */
+#define GAME_MESSAGES(g) \
+	(!(g)->simulation && !(g)->silent && !(g)->fast_forward)
+
+/*
+ * Manipulate sets of deck indices.
+ */
+#define SET_ADD(set, x)    ((set)[(x) >> 6] |= 1ULL << ((x) & 63))
+#define SET_REMOVE(set, x) ((set)[(x) >> 6] &= ~(1ULL << ((x) & 63)))
+#define SET_HAS(set, x)    (((set)[(x) >> 6] >> ((x) & 63)) & 1)
+
+/*
+ * Count bits set in a word, and find the lowest set bit.
+ */
+#ifdef __GNUC__
+#define BIT_COUNT(x) __builtin_popcountll(x)
+#define BIT_FIRST(x) __builtin_ctzll(x)
+#else
+#define BIT_COUNT(x) bit_count(x)
+#define BIT_FIRST(x) bit_first(x)
+#endif
+
 /*
  * External functions.
  */
@@ -1144,6 +1261,9 @@ extern void read_campaign(void);
 extern campaign *find_campaign(char *name);
 extern void apply_campaign(game *g);
 extern void init_game(game *g);
+extern void copy_game(game *dest, game *src);
+extern int bit_count(uint64_t x);
+extern int bit_first(uint64_t x);
 extern int simple_rand(unsigned int *seed);
 extern int next_choice(int* log, int pos);
 extern int count_player_area(game *g, int who, int where);
@@ -1154,6 +1274,10 @@ extern int prestige_on_tile(game *g, int who);
 extern int first_draw(game *g);
 extern void move_card(game *g, int which, int who, int where);
 extern void move_start(game *g, int which, int who, int where);
+extern int card_start_owner(game *g, int which);
+extern int card_start_where(game *g, int which);
+extern int start_list_head(game *g, int who, int where);
+extern int start_list_next(game *g, int who, int where, int x);
 extern int draw_card(game *g, int who, char *reason);
 extern void draw_cards(game *g, int who, int num, char *reason);
 extern void start_prestige(game *g);
@@ -1243,11 +1367,33 @@ extern void declare_winner(game *g);
 extern void ai_debug(game *g, double win_prob[MAX_PLAYER][MAX_PLAYER],
                               double *role[], double *action_score[],
                               int *num_action);
+extern uint64_t ai_state_hash(game *g, int who);
+extern void ai_game_result(game *g, int who, double result[MAX_PLAYER]);
+extern struct net *ai_eval_inputs(game *g, int who);
+extern struct net *ai_role_inputs(game *g, int who);
+extern int ai_role_output(game *g, int who);
 
 extern int load_game(game *g, char *filename);
 extern int save_game(game *g, char *filename, int player_us);
 extern void write_game(game *g, FILE *fff, int player_us);
+extern int archive_game(game *g, char *filename, int player_us,
+                        unsigned char *pool, int pool_len);
+extern int load_archive_game(game *g, char *filename, int which,
+                             unsigned char *pool, int *pool_len);
 extern char *xml_escape(const char *s);
+extern void write_export_start(FILE *fff, char *style_sheet, char *top,
+                               char *server);
+extern void write_export_setup(game *g, FILE *fff);
+extern void write_export_status(game *g, FILE *fff, const char *message);
+extern void write_export_player(game *g, FILE *fff, int n, int player_us,
+                                int num_special, card **special_cards);
+extern void write_export(game *g, FILE *fff, char *style_sheet,
+                         char *server, int player_us, const char *message,
+                         int num_special, card** special_cards,
+                         int export_card_locations,
+                         void (*export_log)(FILE *fff, int gid),
+                         void (*export_callback)(FILE *fff, int gid),
+                         int gid);
 extern int export_game(game *g, char *filename, char *style_sheet,
                        char *server, int player_us, const char *message,
                        int num_special, card** special_cards,
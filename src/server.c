@@ -26,6 +26,8 @@
 #include <mysql/mysql.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <sys/un.h>
+#include <ucontext.h>
 
 /*
  * Server settings.
@@ -48,11 +50,31 @@
  */
 #define MAX_RAND     1024
 
+/*
+ * Maximum number of game sessions.
+ */
+#define MAX_SESSION  1024
+
 /*
  * Size (in int) of the choice log of a player.
  */
 #define CHOICE_LOG_LEN    4096
 
+/*
+ * Game coroutine states (when games run on the thread pool).
+ */
+#define CO_NONE      0
+#define CO_NEW       1
+#define CO_RUNNING   2
+#define CO_WAITING   3
+#define CO_QUEUED    4
+#define CO_DONE      5
+
+/*
+ * Stack size of a game coroutine.
+ */
+#define CO_STACK_SIZE (512 * 1024)
+
 /*
  * A connection from a client.
  */
@@ -226,6 +248,24 @@ typedef struct session
 	/* Time since last player joined */
 	time_t last_join;
 
+	/* Time each player was last asked for a choice (for metrics) */
+	double asked[MAX_PLAYER];
+
+	/* Coroutine state of game (when running on the thread pool) */
+	int co_state;
+
+	/* Saved execution context of game and of the pool thread running it */
+	ucontext_t co_ctx;
+	ucontext_t co_caller;
+
+	/* Stack of game coroutine */
+	void *co_stack;
+
+	/* Log message rows waiting to be saved to the database */
+	char *msg_rows;
+	int msg_len;
+	int msg_size;
+
 } session;
 
 
@@ -238,7 +278,7 @@ static int num_conn;
 /*
  * List of active game sessions.
  */
-static session s_list[1024];
+static session s_list[MAX_SESSION];
 static int num_session;
 
 /*
@@ -286,6 +326,102 @@ static char* server_name = NULL;
  */
 static int debug_server = 0;
 
+/*
+ * AI wall time per decision (in seconds, passed to AI clients, zero for
+ * no limit).
+ */
+static char* ai_budget = "0";
+
+/*
+ * AI wall time per decision in games without timeouts.
+ */
+static char* ai_budget_slow = "0";
+
+/*
+ * Process group of AI client processes (zero if none started yet).
+ */
+static pid_t ai_pgid;
+
+/*
+ * Path of admin socket for metrics (none if NULL).
+ */
+static char* admin_path = NULL;
+
+/*
+ * Amount of buffered log message rows that forces a database write.
+ */
+#define MAX_MSG_ROWS (64 * 1024)
+
+/*
+ * Mutex protecting buffered log messages.
+ */
+static pthread_mutex_t msg_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Number of threads running game coroutines (zero for a thread per game).
+ */
+static int game_pool_size = 0;
+
+/*
+ * Queue of game sessions ready to run on the thread pool.
+ *
+ * A session is queued at most once at a time, so the queue never holds
+ * more than MAX_SESSION entries.
+ */
+static int pool_queue[MAX_SESSION];
+static int pool_first, pool_len;
+
+/*
+ * Mutex and condition variable protecting the pool queue.
+ */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Number of latency histogram buckets.
+ */
+#define MAX_BUCKET 12
+
+/*
+ * Upper bounds (in seconds) of latency histogram buckets.
+ */
+static double bucket_bound[MAX_BUCKET] =
+{
+	0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+	0.05, 0.1, 0.25, 0.5, 1.0, 5.0
+};
+
+/*
+ * A latency histogram.
+ */
+typedef struct histogram
+{
+	/* Number of observations at or below each bucket bound */
+	long bucket[MAX_BUCKET];
+
+	/* Number and sum of all observations */
+	long count;
+	double sum;
+
+} histogram;
+
+/*
+ * Number of message types counted.
+ */
+#define MAX_MSG_TYPE 128
+
+/*
+ * Server metrics.
+ */
+static histogram db_latency, ai_latency, loop_latency;
+static long msg_in[MAX_MSG_TYPE], msg_out[MAX_MSG_TYPE];
+static int num_games_running;
+
+/*
+ * Mutex protecting server metrics.
+ */
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Connection to the database server.
  */
@@ -322,6 +458,81 @@ static void server_log(char *format, ...)
 	printf("\n");
 }
 
+/*
+ * Return the current time in seconds, for latency metrics.
+ */
+static double metric_time(void)
+{
+	struct timespec ts;
+
+	/* Get monotonic time */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	/* Convert to seconds */
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Add an observation to a latency histogram.
+ */
+static void observe(histogram *h, double t)
+{
+	int i;
+
+	/* Grab metrics mutex */
+	pthread_mutex_lock(&metrics_mutex);
+
+	/* Loop over buckets */
+	for (i = 0; i < MAX_BUCKET; i++)
+	{
+		/* Count in each bucket the observation fits */
+		if (t <= bucket_bound[i]) h->bucket[i]++;
+	}
+
+	/* Add to totals */
+	h->count++;
+	h->sum += t;
+
+	/* Release metrics mutex */
+	pthread_mutex_unlock(&metrics_mutex);
+}
+
+/*
+ * Count a message of the given type.
+ */
+static void count_msg(long *counts, int type)
+{
+	/* Ignore unknown types */
+	if (type < 0 || type >= MAX_MSG_TYPE) return;
+
+	/* Grab metrics mutex */
+	pthread_mutex_lock(&metrics_mutex);
+
+	/* Count message */
+	counts[type]++;
+
+	/* Release metrics mutex */
+	pthread_mutex_unlock(&metrics_mutex);
+}
+
+/*
+ * Perform a database query, recording its latency.
+ */
+static int db_query(char *query)
+{
+	double start = metric_time();
+	int rv;
+
+	/* Perform query */
+	rv = mysql_query(mysql, query);
+
+	/* Record latency */
+	observe(&db_latency, metric_time() - start);
+
+	/* Return result */
+	return rv;
+}
+
 
 /*
  * Check for a user in the database with the given password.
@@ -346,7 +557,7 @@ static int db_user(char *user, char *pass)
 	sprintf(query, "SELECT pass, uid FROM users WHERE user='%s'", euser);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res1 = mysql_store_result(mysql);
@@ -362,13 +573,13 @@ static int db_user(char *user, char *pass)
 		        ('%s', SHA1('%s'))", euser, epass);
 
 		/* Send query */
-		mysql_query(mysql, query);
+		db_query(query);
 
 		/* Get ID of user inserted */
 		strcpy(query, "SELECT LAST_INSERT_ID()");
 
 		/* Run query */
-		mysql_query(mysql, query);
+		db_query(query);
 
 		/* Fetch results */
 		res1 = mysql_store_result(mysql);
@@ -390,7 +601,7 @@ static int db_user(char *user, char *pass)
 	sprintf(query, "SELECT SHA1('%s')", epass);
 
 	/* Send query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res2 = mysql_store_result(mysql);
@@ -433,7 +644,7 @@ static void db_user_name(int uid, char *name)
 	sprintf(query, "SELECT user FROM users WHERE uid=%d", uid);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res = mysql_store_result(mysql);
@@ -479,7 +690,7 @@ static int db_new_game(int sid)
 	        s_ptr->disable_takeover, s_ptr->speed, VERSION);
 
 	/* Send query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Check for error */
 	if (*mysql_error(mysql))
@@ -493,7 +704,7 @@ static int db_new_game(int sid)
 	strcpy(query, "SELECT LAST_INSERT_ID()");
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res = mysql_store_result(mysql);
@@ -522,7 +733,7 @@ static void db_load_sessions(void)
 	int sid = 0;
 
 	/* Run query */
-	mysql_query(mysql, "SELECT gid, description, pass, created, state, \
+	db_query("SELECT gid, description, pass, created, state, \
 	                           minp, maxp, exp, adv, dis_goal, \
 	                           dis_takeover, speed \
 	                    FROM games \
@@ -531,8 +742,8 @@ static void db_load_sessions(void)
 	/* Fetch results */
 	res = mysql_store_result(mysql);
 
-	/* Loop over rows returned */
-	while ((row = mysql_fetch_row(res)))
+	/* Loop over rows returned (while sessions remain) */
+	while (sid < MAX_SESSION && (row = mysql_fetch_row(res)))
 	{
 		/* Get pointer to session */
 		s_ptr = &s_list[sid];
@@ -596,7 +807,7 @@ static void db_load_attendance(void)
 	int i;
 
 	/* Run query */
-	mysql_query(mysql, "SELECT uid, gid, ai \
+	db_query("SELECT uid, gid, ai \
 	                    FROM attendance \
 	                    JOIN games USING (gid) \
 	                    WHERE state='WAITING' OR state='STARTED' \
@@ -665,7 +876,7 @@ static void db_join_game(int uid, int gid)
 	        uid, gid);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 }
 
 /*
@@ -680,7 +891,7 @@ static void db_leave_game(int uid, int gid)
 	        uid, gid);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 }
 
 /*
@@ -701,7 +912,7 @@ static int db_load_game_state(int sid)
 	sprintf(query, "SELECT pool FROM seed WHERE gid=%d", s_ptr->gid);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res = mysql_store_result(mysql);
@@ -733,7 +944,7 @@ static int db_load_game_state(int sid)
 		        s_ptr->gid, s_ptr->uids[i]);
 
 		/* Run query */
-		mysql_query(mysql, query);
+		db_query(query);
 
 		/* Fetch results */
 		res = mysql_store_result(mysql);
@@ -788,7 +999,7 @@ static void db_save_game_state(int sid)
 	        s_ptr->gid);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* No need to save further data if game has not started or is finished */
 	if (s_ptr->state == SS_WAITING ||
@@ -804,7 +1015,7 @@ static void db_save_game_state(int sid)
 	        s_ptr->gid, pool);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 }
 
 /*
@@ -825,7 +1036,7 @@ static void db_save_seats(int sid)
 		                i, s_ptr->gid, s_ptr->uids[i]);
 
 		/* Run query */
-		mysql_query(mysql, query);
+		db_query(query);
 	}
 }
 
@@ -848,12 +1059,67 @@ static void db_save_ai_control(int sid)
 		                s_ptr->uids[i]);
 
 		/* Run query */
-		mysql_query(mysql, query);
+		db_query(query);
+	}
+}
+
+/*
+ * Write the buffered game messages of a session to the database.
+ */
+static void db_flush_messages(int sid)
+{
+	session *s_ptr = &s_list[sid];
+	char *query, *head = "INSERT INTO messages (gid, uid, message, format) "
+	                     "VALUES ";
+
+	/* Grab message mutex */
+	pthread_mutex_lock(&msg_mutex);
+
+	/* Check for nothing to save */
+	if (!s_ptr->msg_len)
+	{
+		/* Release mutex */
+		pthread_mutex_unlock(&msg_mutex);
+		return;
+	}
+
+	/* Create insertion query */
+	query = (char *)malloc(strlen(head) + s_ptr->msg_len + 1);
+	strcpy(query, head);
+	strcat(query, s_ptr->msg_rows);
+
+	/* Clear buffered rows */
+	s_ptr->msg_len = 0;
+
+	/*
+	 * Send query.
+	 *
+	 * The mutex is held so that rows from a later flush can not be
+	 * inserted first.
+	 */
+	db_query(query);
+
+	/* Release mutex */
+	pthread_mutex_unlock(&msg_mutex);
+
+	/* Free query */
+	free(query);
+
+	/* Check for error */
+	if (*mysql_error(mysql))
+	{
+		/* Print error */
+		server_log("%s", mysql_error(mysql));
+		exit(1);
 	}
 }
 
 /*
  * Save a player's choice log to the database.
+ *
+ * Buffered messages are written first.  A game restarted from its saved
+ * choices replays them without saving messages again, so any message
+ * still buffered once a choice is saved would be lost.
  */
 static void db_save_choices(int sid, int who)
 {
@@ -861,6 +1127,9 @@ static void db_save_choices(int sid, int who)
 	player *p_ptr;
 	char query[20000], log[20000];
 
+	/* Save messages produced so far */
+	db_flush_messages(sid);
+
 	/* Get player pointer */
 	p_ptr = &s_ptr->g.p[who];
 
@@ -873,7 +1142,7 @@ static void db_save_choices(int sid, int who)
 	        s_ptr->uids[who], log);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 }
 
 /*
@@ -908,7 +1177,7 @@ static void db_save_waiting(int sid, int who)
 	               state_str, s_ptr->gid, s_ptr->uids[who]);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 }
 
 /*
@@ -927,7 +1196,7 @@ static void export_log(FILE *fff, int gid)
 	               "WHERE gid=%d ORDER BY mid", gid);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res = mysql_store_result(mysql);
@@ -1021,7 +1290,7 @@ static void db_save_results(int sid)
 		        p_ptr->winner);
 
 		/* Run query */
-		mysql_query(mysql, query);
+		db_query(query);
 	}
 
 	/* Create file name */
@@ -1043,38 +1312,150 @@ static void db_save_results(int sid)
 
 /*
  * Saves a game message to the database.
+ *
+ * Messages are buffered per session and written with a single query
+ * before the next choice is saved or the game waits on a player (see
+ * db_flush_messages).
  */
 static void db_save_message(int sid, int uid, char* txt, char* tag)
 {
-	char query[1024];
+	session *s_ptr = &s_list[sid];
+	char row[2200];
 	char etxt[1024], etag[1024];
+	int len;
 
 	/* Do not save message if game is replaying */
-	if (s_list[sid].replaying) return;
+	if (s_ptr->replaying) return;
 
 	/* Escape message and format */
 	mysql_real_escape_string(mysql, etxt, txt, strlen(txt));
 	mysql_real_escape_string(mysql, etag, tag, strlen(tag));
 
-	/* Create insertion query */
-	sprintf(query, "INSERT INTO messages (gid, uid, message, format) \
-	                VALUES (%d, %d, '%s', '%s')",
-	        s_list[sid].gid, uid, etxt, etag);
+	/* Grab message mutex */
+	pthread_mutex_lock(&msg_mutex);
 
-	/* Send query */
-	mysql_query(mysql, query);
+	/* Create row, separated from earlier rows */
+	len = sprintf(row, "%s(%d, %d, '%s', '%s')", s_ptr->msg_len ? ", " : "",
+	              s_ptr->gid, uid, etxt, etag);
 
-	/* Check for error */
-	if (*mysql_error(mysql))
+	/* Check for insufficient buffer size */
+	if (s_ptr->msg_size < s_ptr->msg_len + len + 1)
+	{
+		/* Grow buffer */
+		s_ptr->msg_size = 2 * (s_ptr->msg_len + len + 1);
+
+		/* Reallocate buffer */
+		s_ptr->msg_rows = (char *)realloc(s_ptr->msg_rows,
+		                                  s_ptr->msg_size);
+	}
+
+	/* Add row to buffer */
+	strcpy(s_ptr->msg_rows + s_ptr->msg_len, row);
+	s_ptr->msg_len += len;
+
+	/* Release mutex */
+	pthread_mutex_unlock(&msg_mutex);
+
+	/* Write rows if too many are buffered */
+	if (s_ptr->msg_len > MAX_MSG_ROWS) db_flush_messages(sid);
+}
+
+/*
+ * Add a message to a client's outgoing buffer.
+ *
+ * If flush is set, try to send the buffer right away.  Otherwise the
+ * main loop sends it once the socket is ready for writing.
+ */
+static void queue_msg(int cid, char *msg, int flush)
+{
+	conn *c;
+	int type, size, x;
+	char *ptr;
+
+	/* Ensure valid connection */
+	if (cid < 0) return;
+
+	/* Get connection pointer */
+	c = &c_list[cid];
+
+	/* Check for kicked player */
+	if (c->fd < 0) return;
+
+	/* Go to start of message */
+	ptr = msg;
+
+	/* Read type and size */
+	get_integer(&type, msg, HEADER_LEN, &ptr);
+	get_integer(&size, msg, HEADER_LEN, &ptr);
+
+	/* Count outgoing message */
+	count_msg(msg_out, type);
+
+	/* Grab mutex for connection */
+	pthread_mutex_lock(&c->conn_mutex);
+
+	/* Check for insufficient buffer size to hold message */
+	if (c->out_size < c->out_len + size)
 	{
+		/* Grow buffer by at least doubling it */
+		c->out_size = 2 * c->out_size > c->out_len + size ?
+		              2 * c->out_size : c->out_len + size;
+
+		/* Reallocate buffer */
+		c->out_buf = (char *)realloc(c->out_buf, c->out_size);
+	}
+
+	/* Copy current message to end of buffer */
+	memcpy(c->out_buf + c->out_len, msg, size);
+
+	/* Add to current buffer length */
+	c->out_len += size;
+
+	/* Check for sending left to main loop */
+	if (!flush)
+	{
+		/* Release mutex */
+		pthread_mutex_unlock(&c->conn_mutex);
+		return;
+	}
+
+	/* Attempt to send full amount of buffer */
+	x = send(c->fd, c->out_buf, c->out_len, 0);
+
+	/* Check for errors */
+	if (x < 0)
+	{
+		/* Check for try again error */
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			/* Release mutex */
+			pthread_mutex_unlock(&c->conn_mutex);
+			return;
+		}
+
 		/* Print error */
-		server_log("%s", mysql_error(mysql));
-		exit(1);
+		perror("send");
+
+		/* Release mutex */
+		pthread_mutex_unlock(&c->conn_mutex);
+		return;
 	}
+
+	/* Reduce buffer length by amount sent */
+	c->out_len -= x;
+
+	/* Shift buffer */
+	memmove(c->out_buf, c->out_buf + x, c->out_len);
+
+	/* Release connection mutex */
+	pthread_mutex_unlock(&c->conn_mutex);
 }
 
 /*
  * Replays game messages to a client.
+ *
+ * The messages are only queued, so that they go out in a few large
+ * writes instead of one write each.
  */
 static void replay_messages(int gid, int cid)
 {
@@ -1091,7 +1472,7 @@ static void replay_messages(int gid, int cid)
 	               gid, c_list[cid].uid, FORMAT_CHAT);
 
 	/* Run query */
-	mysql_query(mysql, query);
+	db_query(query);
 
 	/* Fetch results */
 	res = mysql_store_result(mysql);
@@ -1114,8 +1495,8 @@ static void replay_messages(int gid, int cid)
 			/* Finish message */
 			finish_msg(msg, ptr);
 
-			/* Send to client */
-			send_msg(cid, msg);
+			/* Queue for client */
+			queue_msg(cid, msg, 0);
 		}
 
 		/* Check for chat message */
@@ -1145,8 +1526,8 @@ static void replay_messages(int gid, int cid)
 			/* Finish message */
 			finish_msg(msg, ptr);
 
-			/* Send to client */
-			send_msg(cid, msg);
+			/* Queue for client */
+			queue_msg(cid, msg, 0);
 		}
 
 		/* Formatted message */
@@ -1164,8 +1545,8 @@ static void replay_messages(int gid, int cid)
 			/* Finish message */
 			finish_msg(msg, ptr);
 
-			/* Send to client */
-			send_msg(cid, msg);
+			/* Queue for client */
+			queue_msg(cid, msg, 0);
 		}
 	}
 
@@ -1174,75 +1555,12 @@ static void replay_messages(int gid, int cid)
 }
 
 /*
- * Send a message to a client.
- */
-void send_msg(int cid, char *msg)
-{
-	conn *c;
-	int size, x;
-	char *ptr;
-
-	/* Ensure valid connection */
-	if (cid < 0) return;
-
-	/* Get connection pointer */
-	c = &c_list[cid];
-
-	/* Check for kicked player */
-	if (c->fd < 0) return;
-
-	/* Go to size area of message */
-	ptr = msg + 4;
-
-	/* Read size */
-	get_integer(&size, msg, HEADER_LEN, &ptr);
-
-	/* Grab mutex for connection */
-	pthread_mutex_lock(&c->conn_mutex);
-
-	/* Check for insufficient buffer size to hold message */
-	if (c->out_size < c->out_len + size)
-	{
-		/* Reallocate buffer */
-		c->out_buf = (char *)realloc(c->out_buf, c->out_len + size);
-	}
-
-	/* Copy current message to end of buffer */
-	memcpy(c->out_buf + c->out_len, msg, size);
-
-	/* Add to current buffer length */
-	c->out_len += size;
-
-	/* Attempt to send full amount of buffer */
-	x = send(c->fd, c->out_buf, c->out_len, 0);
-
-	/* Check for errors */
-	if (x < 0)
-	{
-		/* Check for try again error */
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
-		{
-			/* Release mutex */
-			pthread_mutex_unlock(&c->conn_mutex);
-			return;
-		}
-
-		/* Print error */
-		perror("send");
-
-		/* Release mutex */
-		pthread_mutex_unlock(&c->conn_mutex);
-		return;
-	}
-
-	/* Reduce buffer length by amount sent */
-	c->out_len -= x;
-
-	/* Shift buffer */
-	memmove(c->out_buf, c->out_buf + x, c->out_len);
-
-	/* Release connection mutex */
-	pthread_mutex_unlock(&c->conn_mutex);
+ * Send a message to a client.
+ */
+void send_msg(int cid, char *msg)
+{
+	/* Queue message and try to send it */
+	queue_msg(cid, msg, 1);
 }
 
 /*
@@ -1250,6 +1568,9 @@ void send_msg(int cid, char *msg)
  */
 static int new_ai_client(int sid)
 {
+	sigset_t mask, old_mask;
+	char *budget;
+	pid_t pid, pgid;
 	int fds[2];
 	int i;
 
@@ -1274,8 +1595,19 @@ static int new_ai_client(int sid)
 	/* Create a socket pair to communicate with AI client */
 	socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
 
+	/* Join the AI process group if it still has members */
+	pgid = (ai_pgid > 0 && !killpg(ai_pgid, 0)) ? ai_pgid : 0;
+
+	/*
+	 * Block profile requests until the AI client has installed its
+	 * handler, since they would otherwise kill it while it starts.
+	 */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+
 	/* Fork a child process */
-	switch (fork())
+	switch (pid = fork())
 	{
 		/* Error */
 		case -1:
@@ -1290,22 +1622,30 @@ static int new_ai_client(int sid)
 			/* Close our copy of one end of socket */
 			close(fds[0]);
 
+			/* Enter AI process group (or start a new one) */
+			setpgid(0, pgid);
+
 			/* Close standard input */
 			close(0);
 
 			/* Move socket to FD zero */
 			dup2(fds[1], 0);
 
+			/* Choose AI time budget by game speed */
+			budget = s_list[sid].speed ? ai_budget_slow : ai_budget;
+
 			/* Check for local binary */
 			if (access("./ai_client", X_OK) != -1)
 			{
 				/* Execute AI client program from local folder */
-				execl("./ai_client", "ai_client", NULL);
+				execl("./ai_client", "ai_client", "-t", budget,
+				      NULL);
 			}
 			else
 			{
 				/* Execute AI client program from bin folder */
-				execl(BINDIR "/ai_client", "ai_client", NULL);
+				execl(BINDIR "/ai_client", "ai_client", "-t",
+				      budget, NULL);
 			}
 
 			/* XXX */
@@ -1315,9 +1655,18 @@ static int new_ai_client(int sid)
 		/* Server */
 		default:
 
+			/* Accept profile requests again */
+			pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
 			/* Close our copy of one end of socket */
 			close(fds[1]);
 
+			/* Place child in AI process group */
+			setpgid(pid, pgid ? pgid : pid);
+
+			/* Remember new group */
+			if (!pgid) ai_pgid = pid;
+
 			/* Remember socket */
 			c_list[i].fd = fds[0];
 			break;
@@ -1645,14 +1994,34 @@ static void server_wait(game *g, int who)
 	/* Check if we are waiting on player */
 	if (s_ptr->waiting[who])
 	{
+		/* Save messages so far before blocking */
+		db_flush_messages(g->session_id);
+
 		/* Wait until player is ready */
 		while (s_ptr->waiting[who])
 		{
 			/* Log message */
 			server_log("S:%d waiting on player %d", g->session_id, who);
 
-			/* Wait for signal */
-			pthread_cond_wait(&s_ptr->wait_cond, &s_ptr->session_mutex);
+			/* Check for game running on thread pool */
+			if (game_pool_size)
+			{
+				/* Mark game as waiting to be resumed */
+				s_ptr->co_state = CO_WAITING;
+
+				/*
+				 * Return to pool thread, which releases the
+				 * session mutex.  We continue here (holding
+				 * the mutex again) once the game is resumed.
+				 */
+				swapcontext(&s_ptr->co_ctx, &s_ptr->co_caller);
+			}
+			else
+			{
+				/* Wait for signal */
+				pthread_cond_wait(&s_ptr->wait_cond,
+				                  &s_ptr->session_mutex);
+			}
 		}
 
 		/* Log message */
@@ -1660,6 +2029,55 @@ static void server_wait(game *g, int who)
 	}
 }
 
+/*
+ * Add a session to the queue of games ready to run on the thread pool.
+ */
+static void pool_push(int sid)
+{
+	/* Grab pool mutex */
+	pthread_mutex_lock(&pool_mutex);
+
+	/* Check for full queue */
+	if (pool_len == MAX_SESSION)
+	{
+		/* Print error and exit */
+		server_log("Pool queue overflow (S:%d)", sid);
+		exit(1);
+	}
+
+	/* Add session to end of queue */
+	pool_queue[(pool_first + pool_len++) % MAX_SESSION] = sid;
+
+	/* Wake a pool thread */
+	pthread_cond_signal(&pool_cond);
+
+	/* Release pool mutex */
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+/*
+ * Let a game that may be waiting for an answer continue.
+ *
+ * The session mutex must be held.
+ */
+static void wake_game(session *s_ptr)
+{
+	/* Check for game with its own thread */
+	if (!game_pool_size)
+	{
+		/* Signal game thread to continue */
+		pthread_cond_signal(&s_ptr->wait_cond);
+		return;
+	}
+
+	/* Do nothing unless game is suspended */
+	if (s_ptr->co_state != CO_WAITING) return;
+
+	/* Queue game to be resumed */
+	s_ptr->co_state = CO_QUEUED;
+	pool_push(s_ptr->sid);
+}
+
 /*
  * Initialize random byte pool for a session.
  *
@@ -1804,16 +2222,27 @@ static void obfuscate_game(game *ob, game *g, int who)
 	/* Copy game state */
 	*ob = *g;
 
+	/* Loop over cards */
+	for (i = 0; i < g->deck_size; i++)
+	{
+		/* Store start of phase location for every card */
+		ob->deck[i].start_owner = card_start_owner(g, i);
+		ob->deck[i].start_where = card_start_where(g, i);
+	}
+
+	/* Start of phase locations are now valid for every card */
+	memset(ob->moved_set, 0xff, sizeof(ob->moved_set));
+
 	/* Loop over cards */
 	for (i = 0; i < g->deck_size; i++)
 	{
 		/* Check for active card (known to all) */
 		if (g->deck[i].where == WHERE_ACTIVE) continue;
-		if (g->deck[i].start_where == WHERE_ACTIVE) continue;
+		if (card_start_where(g, i) == WHERE_ACTIVE) continue;
 
 		/* Check for card owned by player (but not a good) */
 		if ((g->deck[i].owner == who ||
-		     g->deck[i].start_owner == who) &&
+		     card_start_owner(g, i) == who) &&
 		    g->deck[i].where != WHERE_GOOD)
 			continue;
 
@@ -1836,11 +2265,11 @@ static void obfuscate_game(game *ob, game *g, int who)
 
 		/* Skip active cards */
 		if (g->deck[i].where == WHERE_ACTIVE) continue;
-		if (g->deck[i].start_where == WHERE_ACTIVE) continue;
+		if (card_start_where(g, i) == WHERE_ACTIVE) continue;
 
 		/* Skip cards known by owner */
 		if ((g->deck[i].owner == who ||
-		     g->deck[i].start_owner == who) &&
+		     card_start_owner(g, i) == who) &&
 		    g->deck[i].where != WHERE_GOOD)
 			continue;
 
@@ -1850,8 +2279,8 @@ static void obfuscate_game(game *ob, game *g, int who)
 		/* Copy card location */
 		ob->deck[j].where = g->deck[i].where;
 		ob->deck[j].owner = g->deck[i].owner;
-		ob->deck[j].start_where = g->deck[i].start_where;
-		ob->deck[j].start_owner = g->deck[i].start_owner;
+		ob->deck[j].start_where = card_start_where(g, i);
+		ob->deck[j].start_owner = card_start_owner(g, i);
 	}
 
 	/* Loop over cards */
@@ -2298,6 +2727,9 @@ static void ask_client(int sid, int who)
 	/* Finish message */
 	finish_msg(msg, ptr);
 
+	/* Remember time of question */
+	s_ptr->asked[who] = metric_time();
+
 	/* Send message to client */
 	send_msg(cid, msg);
 }
@@ -2427,8 +2859,13 @@ static void send_gamechat(int sid, int uid, char *user, char *text, int save)
 {
 	char msg[1024], *ptr = msg;
 
-	/* Save message to db */
-	if (save) db_save_message(sid, uid, text, FORMAT_CHAT);
+	/* Check for message to be saved */
+	if (save)
+	{
+		/* Save message to db, along with earlier game messages */
+		db_save_message(sid, uid, text, FORMAT_CHAT);
+		db_flush_messages(sid);
+	}
 
 	/* Start at beginning of message */
 	ptr = msg;
@@ -2740,11 +3177,21 @@ static void handle_choice(int cid, int size)
 		server_log("S:%d P:%d READY", sid, who);
 	}
 
+	/* Check for answer from AI to a question */
+	if (c_list[cid].ai && got_choice && s_ptr->asked[who] > 0)
+	{
+		/* Record AI decision latency */
+		observe(&ai_latency, metric_time() - s_ptr->asked[who]);
+
+		/* Question answered */
+		s_ptr->asked[who] = 0;
+	}
+
 	/* Mark time of activity */
 	c_list[cid].last_active = time(NULL);
 
 	/* Signal game thread to continue */
-	pthread_cond_signal(&s_ptr->wait_cond);
+	wake_game(s_ptr);
 
 	/* Update waiting status */
 	update_waiting(sid);
@@ -2812,7 +3259,7 @@ static void handle_prepare(int cid)
 	}
 
 	/* Signal game thread to continue */
-	pthread_cond_signal(&s_ptr->wait_cond);
+	wake_game(s_ptr);
 
 	/* Update waiting status */
 	update_waiting(sid);
@@ -3128,6 +3575,9 @@ static void switch_ai(int sid, int who)
 
 		/* Save waiting status */
 		db_save_waiting(sid, who);
+
+		/* Let game continue */
+		wake_game(s_ptr);
 	}
 
 	/* Send new waiting status */
@@ -3150,6 +3600,11 @@ void *run_game(void *arg)
 	session *s_ptr = (session *)arg;
 	int i;
 
+	/* Count running game */
+	pthread_mutex_lock(&metrics_mutex);
+	num_games_running++;
+	pthread_mutex_unlock(&metrics_mutex);
+
 	/* Initialize condition variable */
 	pthread_cond_init(&s_ptr->wait_cond, NULL);
 
@@ -3177,6 +3632,9 @@ void *run_game(void *arg)
 	/* Save session ID in game structure */
 	s_ptr->g.session_id = s_ptr - s_list;
 
+	/* Fast-forward through choices that were already made */
+	s_ptr->g.fast_forward = s_ptr->replaying;
+
 	/* Send meta status to clients */
 	update_meta(s_ptr - s_list);
 
@@ -3221,16 +3679,116 @@ void *run_game(void *arg)
 	/* Release mutex */
 	pthread_mutex_unlock(&s_ptr->session_mutex);
 
+	/* Save remaining messages */
+	db_flush_messages(s_ptr->sid);
+
 	/* Save state */
 	db_save_game_state(s_ptr->sid);
 
 	/* Save results */
 	db_save_results(s_ptr->sid);
 
+	/* Game finished */
+	pthread_mutex_lock(&metrics_mutex);
+	num_games_running--;
+	pthread_mutex_unlock(&metrics_mutex);
+
 	/* Done */
 	return NULL;
 }
 
+/*
+ * Entry point of a game coroutine.
+ */
+static void run_game_co(int sid)
+{
+	/* Run game */
+	run_game(&s_list[sid]);
+
+	/* Mark game as finished */
+	s_list[sid].co_state = CO_DONE;
+
+	/* Returning continues the pool thread (through uc_link) */
+}
+
+/*
+ * Pool thread: run queued game coroutines until they need an answer.
+ */
+static void *pool_thread(void *arg)
+{
+	session *s_ptr;
+	int sid;
+
+	/* Loop forever */
+	while (1)
+	{
+		/* Grab pool mutex */
+		pthread_mutex_lock(&pool_mutex);
+
+		/* Wait for a game to run */
+		while (!pool_len) pthread_cond_wait(&pool_cond, &pool_mutex);
+
+		/* Take first game from queue */
+		sid = pool_queue[pool_first];
+		pool_first = (pool_first + 1) % MAX_SESSION;
+		pool_len--;
+
+		/* Release pool mutex */
+		pthread_mutex_unlock(&pool_mutex);
+
+		/* Get session pointer */
+		s_ptr = &s_list[sid];
+
+		/* Check for game being resumed */
+		if (s_ptr->co_state != CO_NEW)
+		{
+			/* Resumed game expects to hold the session mutex */
+			pthread_mutex_lock(&s_ptr->session_mutex);
+		}
+
+		/* Mark game as running */
+		s_ptr->co_state = CO_RUNNING;
+
+		/* Run game until it waits or finishes */
+		swapcontext(&s_ptr->co_caller, &s_ptr->co_ctx);
+
+		/* Check for finished game */
+		if (s_ptr->co_state == CO_DONE)
+		{
+			/* Free coroutine stack */
+			free(s_ptr->co_stack);
+			s_ptr->co_stack = NULL;
+			continue;
+		}
+
+		/*
+		 * Game has saved its context and is waiting on a player.
+		 * Release the session mutex it holds, so that an answer can
+		 * be delivered.
+		 */
+		pthread_mutex_unlock(&s_ptr->session_mutex);
+	}
+
+	/* Not reached */
+	return NULL;
+}
+
+/*
+ * Start the threads that run game coroutines.
+ */
+static void start_pool(void)
+{
+	pthread_t t;
+	int i;
+
+	/* Create threads */
+	for (i = 0; i < game_pool_size; i++)
+	{
+		/* Create thread */
+		pthread_create(&t, NULL, pool_thread, NULL);
+	}
+}
+
 /*
  * Start a game session.
  */
@@ -3308,6 +3866,23 @@ static void start_session(int sid)
 		db_save_seats(sid);
 	}
 
+	/* Check for games running on thread pool */
+	if (game_pool_size)
+	{
+		/* Create coroutine for game */
+		s_ptr->co_stack = malloc(CO_STACK_SIZE);
+		getcontext(&s_ptr->co_ctx);
+		s_ptr->co_ctx.uc_stack.ss_sp = s_ptr->co_stack;
+		s_ptr->co_ctx.uc_stack.ss_size = CO_STACK_SIZE;
+		s_ptr->co_ctx.uc_link = &s_ptr->co_caller;
+		makecontext(&s_ptr->co_ctx, (void (*)(void))run_game_co, 1, sid);
+
+		/* Queue game to start */
+		s_ptr->co_state = CO_NEW;
+		pool_push(sid);
+		return;
+	}
+
 	/* Start a thread to run game */
 	pthread_create(&t, NULL, run_game, (void *)s_ptr);
 }
@@ -3566,6 +4141,9 @@ static void handle_login(int cid, int size)
 			/* Tell client that game has started */
 			send_msgf(cid, MSG_START, "");
 
+			/* Save buffered messages so they are replayed */
+			db_flush_messages(i);
+
 			/* Replay game messages */
 			replay_messages(s_ptr->gid, cid);
 
@@ -3654,6 +4232,14 @@ static void handle_create(int cid, int size)
 	/* Check for end of list reached */
 	if (sid == num_session)
 	{
+		/* Check for no room for another session */
+		if (sid == MAX_SESSION)
+		{
+			/* Log message */
+			server_log("Denied (too many sessions)");
+			return;
+		}
+
 		/* Increase count of active sessions */
 		num_session++;
 	}
@@ -4379,6 +4965,9 @@ static void handle_msg(int cid)
 	/* Read message size */
 	get_integer(&size, c_list[cid].buf, HEADER_LEN, &ptr);
 
+	/* Count incoming message */
+	count_msg(msg_in, type);
+
 	/* Check for non-login message from client in INIT state */
 	if (c_list[cid].state == CS_INIT && type != MSG_LOGIN)
 	{
@@ -4818,6 +5407,255 @@ static void do_housekeeping(void)
 	}
 }
 
+/*
+ * Print a latency histogram in Prometheus text format.
+ */
+static void print_histogram(FILE *fff, char *name, char *help, histogram *h)
+{
+	int i;
+
+	/* Print description */
+	fprintf(fff, "# HELP %s %s\n", name, help);
+	fprintf(fff, "# TYPE %s histogram\n", name);
+
+	/* Loop over buckets */
+	for (i = 0; i < MAX_BUCKET; i++)
+	{
+		/* Print cumulative count */
+		fprintf(fff, "%s_bucket{le=\"%g\"} %ld\n", name, bucket_bound[i],
+		        h->bucket[i]);
+	}
+
+	/* Print totals */
+	fprintf(fff, "%s_bucket{le=\"+Inf\"} %ld\n", name, h->count);
+	fprintf(fff, "%s_sum %f\n", name, h->sum);
+	fprintf(fff, "%s_count %ld\n", name, h->count);
+}
+
+/*
+ * Print message counts of each type in Prometheus text format.
+ */
+static void print_msg_counts(FILE *fff, char *name, char *help, long *counts)
+{
+	int i;
+
+	/* Print description */
+	fprintf(fff, "# HELP %s %s\n", name, help);
+	fprintf(fff, "# TYPE %s counter\n", name);
+
+	/* Loop over message types */
+	for (i = 0; i < MAX_MSG_TYPE; i++)
+	{
+		/* Skip types never seen */
+		if (!counts[i]) continue;
+
+		/* Print count */
+		fprintf(fff, "%s{type=\"%d\"} %ld\n", name, i, counts[i]);
+	}
+}
+
+/*
+ * Answer a connection on the admin socket with current server metrics.
+ *
+ * The metrics are written in Prometheus text format and the connection
+ * is closed.
+ */
+static void send_metrics(int admin_fd)
+{
+	static char *conn_state[CS_DISCONN + 1] =
+	{
+		"empty", "init", "lobby", "playing", "disconn"
+	};
+	static char *session_state[SS_ABANDONED + 1] =
+	{
+		"empty", "waiting", "started", "done", "abandoned"
+	};
+	int conns[CS_DISCONN + 1] = { 0 }, sessions[SS_ABANDONED + 1] = { 0 };
+	FILE *fff;
+	int i, fd, out_len;
+
+	/* Accept connection */
+	fd = accept(admin_fd, NULL, NULL);
+
+	/* Check for error */
+	if (fd < 0) return;
+
+	/* Open stream for output */
+	fff = fdopen(fd, "w");
+
+	/* Check for error */
+	if (!fff)
+	{
+		/* Close connection */
+		close(fd);
+		return;
+	}
+
+	/* Count connections by state */
+	for (i = 0; i < num_conn; i++)
+	{
+		/* Skip unknown states */
+		if (c_list[i].state < 0 || c_list[i].state > CS_DISCONN) continue;
+
+		/* Count connection */
+		conns[c_list[i].state]++;
+	}
+
+	/* Count sessions by state */
+	for (i = 0; i < num_session; i++)
+	{
+		/* Skip unknown states */
+		if (s_list[i].state < 0 || s_list[i].state > SS_ABANDONED) continue;
+
+		/* Count session */
+		sessions[s_list[i].state]++;
+	}
+
+	/* Print connection counts */
+	fprintf(fff, "# HELP rftg_connections Connections by state.\n");
+	fprintf(fff, "# TYPE rftg_connections gauge\n");
+
+	/* Loop over connection states */
+	for (i = 0; i <= CS_DISCONN; i++)
+	{
+		/* Print count */
+		fprintf(fff, "rftg_connections{state=\"%s\"} %d\n",
+		        conn_state[i], conns[i]);
+	}
+
+	/* Print session counts */
+	fprintf(fff, "# HELP rftg_sessions Sessions by state.\n");
+	fprintf(fff, "# TYPE rftg_sessions gauge\n");
+
+	/* Loop over session states */
+	for (i = 0; i <= SS_ABANDONED; i++)
+	{
+		/* Print count */
+		fprintf(fff, "rftg_sessions{state=\"%s\"} %d\n",
+		        session_state[i], sessions[i]);
+	}
+
+	/* Grab metrics mutex */
+	pthread_mutex_lock(&metrics_mutex);
+
+	/* Print running games */
+	fprintf(fff, "# HELP rftg_games_running Running games.\n");
+	fprintf(fff, "# TYPE rftg_games_running gauge\n");
+	fprintf(fff, "rftg_games_running %d\n", num_games_running);
+
+	/* Print game threads (pool threads, or one per running game) */
+	fprintf(fff, "# HELP rftg_game_threads Threads running games.\n");
+	fprintf(fff, "# TYPE rftg_game_threads gauge\n");
+	fprintf(fff, "rftg_game_threads %d\n",
+	        game_pool_size ? game_pool_size : num_games_running);
+
+	/* Print latency histograms */
+	print_histogram(fff, "rftg_db_query_seconds",
+	                "Database query latency.", &db_latency);
+	print_histogram(fff, "rftg_ai_decision_seconds",
+	                "Time from asking an AI client to its answer.",
+	                &ai_latency);
+	print_histogram(fff, "rftg_loop_seconds",
+	                "Main loop work time after each select.",
+	                &loop_latency);
+
+	/* Print message counts */
+	print_msg_counts(fff, "rftg_messages_in_total",
+	                 "Messages received by type.", msg_in);
+	print_msg_counts(fff, "rftg_messages_out_total",
+	                 "Messages sent by type.", msg_out);
+
+	/* Release metrics mutex */
+	pthread_mutex_unlock(&metrics_mutex);
+
+	/* Print queued outbound bytes */
+	fprintf(fff, "# HELP rftg_conn_out_bytes Unsent bytes per "
+	             "connection.\n");
+	fprintf(fff, "# TYPE rftg_conn_out_bytes gauge\n");
+
+	/* Loop over active connections */
+	for (i = 0; i < num_conn; i++)
+	{
+		/* Skip closed connections */
+		if (c_list[i].fd <= 0) continue;
+
+		/* Get amount of unsent data */
+		pthread_mutex_lock(&c_list[i].conn_mutex);
+		out_len = c_list[i].out_len;
+		pthread_mutex_unlock(&c_list[i].conn_mutex);
+
+		/* Print amount */
+		fprintf(fff, "rftg_conn_out_bytes{cid=\"%d\",ai=\"%d\"} %d\n",
+		        i, c_list[i].ai, out_len);
+	}
+
+	/* Send and close connection */
+	fclose(fff);
+}
+
+/*
+ * Open the admin socket at the given path.
+ *
+ * Return -1 on failure.
+ */
+static int open_admin_socket(char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	/* Check for too long path */
+	if (strlen(path) >= sizeof(addr.sun_path))
+	{
+		/* Message */
+		server_log("Admin socket path too long: %s", path);
+		return -1;
+	}
+
+	/* Create socket */
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	/* Check for error */
+	if (fd < 0)
+	{
+		/* Message */
+		perror("socket");
+		return -1;
+	}
+
+	/* Create address */
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	/* Remove stale socket from earlier run */
+	unlink(path);
+
+	/* Bind and listen */
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(fd, 5) < 0)
+	{
+		/* Message */
+		perror("admin socket");
+		close(fd);
+		return -1;
+	}
+
+	/* Success */
+	return fd;
+}
+
+/*
+ * Ask AI clients to print their decision profiles.
+ *
+ * The AI runs in separate client processes, so the server has no
+ * profile of its own.
+ */
+static void forward_profile(int sig)
+{
+	/* Signal AI process group */
+	if (ai_pgid > 0) killpg(ai_pgid, SIGUSR1);
+}
+
 /*
  * Initialize connection to database, open main listening socket, then loop
  * forever waiting for incoming data on connections.
@@ -4827,8 +5665,9 @@ int main(int argc, char *argv[])
 	struct sockaddr_in listen_addr;
 	struct timeval sel_timeout;
 	fd_set readfds, writefds;
-	int listen_fd;
+	int listen_fd, admin_fd = -1;
 	int i, n;
+	double loop_start;
 	my_bool reconnect = 1;
 	time_t last_housekeep = 0;
 	int port = 16309;
@@ -4857,6 +5696,10 @@ int main(int argc, char *argv[])
 			printf("  -e     Folder to put exported games. Default: \".\"\n");
 			printf("  -s     Server name (to be used in exports). Default: [none]\n");
 			printf("  -ss    XSLT style sheets for exported games. Default: [none]\n");
+			printf("  -ab    A.I. time per decision in seconds. 0 means no limit. Default: 0\n");
+			printf("  -abs   A.I. time per decision in games without timeouts. Default: 0\n");
+			printf("  -admin Unix socket path to serve metrics on. Default: [none]\n");
+			printf("  -gp    Threads hosting all games. 0 means one thread per game. Default: 0\n");
 			printf("  -debug Accept debug card messages.\n");
 			printf("  -h     Print this usage text and exit.\n\n");
 			printf("For more information, see the following web sites:\n");
@@ -4942,6 +5785,34 @@ int main(int argc, char *argv[])
 			export_style_sheet = argv[++i];
 		}
 
+		/* Check for AI time budget */
+		if (!strcmp(argv[i], "-ab"))
+		{
+			/* Set AI time budget */
+			ai_budget = argv[++i];
+		}
+
+		/* Check for AI time budget in games without timeouts */
+		if (!strcmp(argv[i], "-abs"))
+		{
+			/* Set AI time budget */
+			ai_budget_slow = argv[++i];
+		}
+
+		/* Check for game thread pool size */
+		if (!strcmp(argv[i], "-gp"))
+		{
+			/* Set number of pool threads */
+			game_pool_size = atoi(argv[++i]);
+		}
+
+		/* Check for admin socket */
+		if (!strcmp(argv[i], "-admin"))
+		{
+			/* Set admin socket path */
+			admin_path = argv[++i];
+		}
+
 		/* Check for debug server */
 		if (!strcmp(argv[i], "-debug"))
 		{
@@ -4983,6 +5854,9 @@ int main(int argc, char *argv[])
 	db_load_sessions();
 	db_load_attendance();
 
+	/* Start threads to host games, if requested */
+	if (game_pool_size) start_pool();
+
 	/* Start sessions that were running previously */
 	start_all_sessions();
 
@@ -4992,6 +5866,9 @@ int main(int argc, char *argv[])
 	/* Do not wait for forked children processes */
 	signal(SIGCHLD, SIG_IGN);
 
+	/* Pass AI profile requests on to AI clients */
+	signal(SIGUSR1, forward_profile);
+
 	/* Create main socket for new connections */
 	listen_fd = socket(AF_INET, SOCK_STREAM, 0);
 
@@ -5025,6 +5902,16 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
+	/* Check for admin socket requested */
+	if (admin_path)
+	{
+		/* Open admin socket */
+		admin_fd = open_admin_socket(admin_path);
+
+		/* Check for failure */
+		if (admin_fd < 0) exit(1);
+	}
+
 	/* Print ready message */
 	server_log("Server ready. Listening on port %d...", port);
 
@@ -5043,6 +5930,16 @@ int main(int argc, char *argv[])
 		/* Track biggest file descriptor */
 		n = listen_fd;
 
+		/* Check for admin socket */
+		if (admin_fd >= 0)
+		{
+			/* Add admin socket to list */
+			FD_SET(admin_fd, &readfds);
+
+			/* Track biggest file descriptor */
+			if (admin_fd > n) n = admin_fd;
+		}
+
 		/* Loop over active connections */
 		for (i = 0; i < num_conn; i++)
 		{
@@ -5077,6 +5974,16 @@ int main(int argc, char *argv[])
 		/* Wait for activity on any connection */
 		select(n + 1, &readfds, &writefds, NULL, &sel_timeout);
 
+		/* Start timing loop work */
+		loop_start = metric_time();
+
+		/* Check for metrics request */
+		if (admin_fd >= 0 && FD_ISSET(admin_fd, &readfds))
+		{
+			/* Send metrics */
+			send_metrics(admin_fd);
+		}
+
 		/* Check for new incoming connection */
 		if (FD_ISSET(listen_fd, &readfds))
 		{
@@ -5118,5 +6025,8 @@ int main(int argc, char *argv[])
 			/* Remember time */
 			last_housekeep = time(NULL);
 		}
+
+		/* Record loop work time */
+		observe(&loop_latency, metric_time() - loop_start);
 	}
 }
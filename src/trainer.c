@@ -0,0 +1,1084 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2015 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "rftg.h"
+#include "net.h"
+#include <setjmp.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/*
+ * Offline trainer.
+ *
+ * Replays finished games from archives (see replay -a) or save files,
+ * writes the eval and role network inputs seen at the start of every
+ * round to an on-disk buffer together with their targets, and then trains
+ * the networks on the shuffled buffer in minibatches.
+ */
+
+/*
+ * Size of random byte pool used by server games.
+ */
+#define MAX_RAND     1024
+
+/*
+ * Maximum number of states recorded per player (30 rounds and game end).
+ */
+#define MAX_STATE    32
+
+/*
+ * Maximum number of training threads.
+ */
+#define MAX_THREAD   64
+
+/*
+ * Print messages?
+ */
+int verbose = 0;
+
+/*
+ * Random byte pool of the game being replayed (if any).
+ */
+static unsigned char random_pool[MAX_RAND];
+static int random_len, random_pos;
+
+/*
+ * Place to return to when a game runs out of logged choices.
+ */
+static jmp_buf replay_abort;
+
+/*
+ * A game is being replayed, so errors abandon it.
+ */
+static int replaying;
+
+/*
+ * Eval network inputs, predictions and targets of the game being replayed.
+ */
+static float *eval_state;
+static double eval_pred[MAX_PLAYER][MAX_STATE][MAX_PLAYER];
+
+/*
+ * Role network inputs and chosen outputs of the game being replayed.
+ */
+static float *role_state;
+static int role_target[MAX_PLAYER][MAX_STATE];
+
+/*
+ * Number of round-start states recorded in the game being replayed.
+ */
+static int num_state;
+
+/*
+ * Training parameters.
+ */
+static int num_players = 2, expanded = 0, advanced = 0;
+static double lambda = 1.0, factor = 1.0;
+static int epochs = 1, batch_size = 256, num_threads;
+static unsigned int shuffle_seed = 1;
+
+/*
+ * One training thread, with its own copy of the network that shares the
+ * weights of the main network.
+ */
+typedef struct worker
+{
+	/* Network copy (with own deltas and scratch space) */
+	net learn;
+
+	/* Own weight rows (restored before freeing) */
+	double **own_hidden, **own_output;
+
+	/* Buffer file descriptor */
+	int fd;
+
+	/* Record read buffer */
+	float *record;
+
+	/* Inputs and desired outputs of records in this batch */
+	double **input, **desired;
+
+	/* Records to train on in this batch */
+	int *list;
+	int num;
+
+} worker;
+
+/*
+ * Print errors to standard error.
+ */
+void display_error(char *msg)
+{
+	/* Forward message */
+	fprintf(stderr, "%s", msg);
+
+	/*
+	 * The engine aborts after errors such as a choice log that does
+	 * not match the game, so abandon the game being replayed instead.
+	 */
+	if (replaying) longjmp(replay_abort, 1);
+}
+
+/*
+ * Print messages to standard output.
+ */
+void message_add(game *g, char *msg)
+{
+	/* Print if verbose flag set */
+	if (verbose) printf("%s", msg);
+}
+
+/*
+ * Print messages to standard output.
+ */
+void message_add_formatted(game *g, char *msg, char *tag)
+{
+	/* Print without formatting */
+	message_add(g, msg);
+}
+
+/*
+ * Use the game's random byte pool if it has one, and the simple random
+ * number generator otherwise.
+ */
+int game_rand(game *g)
+{
+	unsigned int x;
+
+	/* Check for simulated game or no pool */
+	if (g->simulation || !random_len)
+	{
+		/* Call simple random number generator */
+		return simple_rand(&g->random_seed);
+	}
+
+	/* Check for end of random bytes reached */
+	if (random_pos + 1 >= random_len)
+	{
+		/* XXX Restart from beginning */
+		random_pos = 0;
+	}
+
+	/* Create random number from next two bytes */
+	x = random_pool[random_pos++];
+	x |= random_pool[random_pos++] << 8;
+
+	/* Return low bits */
+	return x & 0x7fff;
+}
+
+/*
+ * A replayed game needs a choice that is not in the log.
+ */
+static void trainer_make_choice(game *g, int who, int type, int list[],
+                                int *nl, int special[], int *ns, int arg1,
+                                int arg2, int arg3)
+{
+	/* Abandon game */
+	longjmp(replay_abort, 1);
+}
+
+/*
+ * Replayed games have nothing to do on rotation.
+ */
+static void trainer_notify_rotation(game *g, int who)
+{
+}
+
+/*
+ * Decision functions for replayed games.
+ */
+static decisions trainer_func =
+{
+	NULL,
+	trainer_notify_rotation,
+	NULL,
+	trainer_make_choice,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+};
+
+/*
+ * Copy a network's inputs to a float array.
+ */
+static void copy_inputs(float *dest, net *learn)
+{
+	int i;
+
+	/* Loop over inputs (and bias) */
+	for (i = 0; i < learn->num_inputs + 1; i++)
+	{
+		/* Copy input */
+		dest[i] = learn->input_value[i];
+	}
+}
+
+/*
+ * Return the size (in floats) of one buffer record for a network.
+ */
+static int record_size(net *learn)
+{
+	/* Inputs, bias and desired outputs */
+	return learn->num_inputs + 1 + learn->num_output;
+}
+
+/*
+ * Record the network inputs of every player at the start of a round.
+ */
+static void record_round(game *g, net *eval, net *role)
+{
+	int i, n;
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Set eval inputs */
+		ai_eval_inputs(g, i);
+
+		/* Copy inputs */
+		copy_inputs(eval_state + (i * MAX_STATE + num_state) *
+		            record_size(eval), eval);
+
+		/* Copy predicted outputs */
+		for (n = 0; n < eval->num_output; n++)
+		{
+			/* Copy prediction */
+			eval_pred[i][num_state][n] = eval->win_prob[n];
+		}
+
+		/* Check for final state */
+		if (g->game_over) continue;
+
+		/* Set role inputs */
+		ai_role_inputs(g, i);
+
+		/* Copy inputs */
+		copy_inputs(role_state + (i * MAX_STATE + num_state) *
+		            record_size(role), role);
+	}
+
+	/* One more state */
+	num_state++;
+}
+
+/*
+ * Write the recorded states of a finished game to the buffers.
+ */
+static void write_records(game *g, net *eval, net *role, FILE *eval_fff,
+                          FILE *role_fff, long *num_eval, long *num_role)
+{
+	double result[MAX_PLAYER], target[MAX_PLAYER];
+	float *rec;
+	int i, j, n;
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Compute final outcome from this player's point of view */
+		ai_game_result(g, i, result);
+
+		/* Start with outcome as target of final state */
+		for (n = 0; n < eval->num_output; n++) target[n] = result[n];
+
+		/* Loop backwards over states */
+		for (j = num_state - 1; j >= 0; j--)
+		{
+			/* Get record */
+			rec = eval_state + (i * MAX_STATE + j) * record_size(eval);
+
+			/* Check for earlier state */
+			if (j < num_state - 1)
+			{
+				/* Blend next state's prediction and target */
+				for (n = 0; n < eval->num_output; n++)
+				{
+					/* Compute lambda-return */
+					target[n] = (1 - lambda) *
+					            eval_pred[i][j + 1][n] +
+					            lambda * target[n];
+				}
+			}
+
+			/* Store target after inputs */
+			for (n = 0; n < eval->num_output; n++)
+			{
+				/* Store target */
+				rec[eval->num_inputs + 1 + n] = target[n];
+			}
+
+			/* Write record */
+			fwrite(rec, sizeof(float), record_size(eval), eval_fff);
+			(*num_eval)++;
+		}
+
+		/* Loop over round-start states (all but final) */
+		for (j = 0; j < num_state - 1; j++)
+		{
+			/* Skip rounds without a matching role output */
+			if (role_target[i][j] < 0) continue;
+
+			/* Get record */
+			rec = role_state + (i * MAX_STATE + j) * record_size(role);
+
+			/* Set chosen output as target */
+			for (n = 0; n < role->num_output; n++)
+			{
+				/* Set target */
+				rec[role->num_inputs + 1 + n] =
+				                     (n == role_target[i][j]);
+			}
+
+			/* Write record */
+			fwrite(rec, sizeof(float), record_size(role), role_fff);
+			(*num_role)++;
+		}
+	}
+}
+
+/*
+ * Set up a game with the configuration being trained.
+ */
+static void setup_game(game *g)
+{
+	static char *names[MAX_PLAYER];
+	char buf[1024];
+	int i;
+
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Create name if needed */
+		if (!names[i])
+		{
+			/* Create player name */
+			sprintf(buf, "Player %d", i);
+			names[i] = strdup(buf);
+		}
+
+		/* Set player name */
+		g->p[i].name = names[i];
+
+		/* Answers come from the log only */
+		g->p[i].control = &trainer_func;
+
+		/* Start at beginning of log */
+		g->p[i].choice_pos = 0;
+		g->p[i].choice_unread_pos = 0;
+	}
+
+	/* Replay game from its own seed */
+	g->random_seed = g->start_seed;
+	random_pos = 0;
+
+	/* Initialize game */
+	init_game(g);
+
+	/* Game is run by trainer */
+	g->session_id = -2;
+
+	/* Initialize AI (loads networks on first call) */
+	for (i = 0; i < g->num_players; i++) ai_func.init(g, i, factor);
+}
+
+/*
+ * Replay one game and write its training records.
+ *
+ * Returns 1 if the game was used and 0 if it was skipped.
+ */
+static int extract_game(game *g, FILE *eval_fff, FILE *role_fff,
+                        long *num_eval, long *num_role)
+{
+	net *eval, *role;
+	int i, more;
+
+	/* Skip games with a different configuration */
+	if (g->num_players != num_players || g->expanded != expanded ||
+	    g->advanced != advanced) return 0;
+
+	/* Set up game */
+	setup_game(g);
+
+	/* Get networks */
+	eval = ai_eval_inputs(g, 0);
+	role = ai_role_inputs(g, 0);
+
+	/* Create state arrays if needed */
+	if (!eval_state)
+	{
+		/* Create arrays */
+		eval_state = (float *)malloc(sizeof(float) * MAX_PLAYER *
+		                             MAX_STATE * record_size(eval));
+		role_state = (float *)malloc(sizeof(float) * MAX_PLAYER *
+		                             MAX_STATE * record_size(role));
+	}
+
+	/* Check for game running out of choices or not matching its log */
+	if (setjmp(replay_abort))
+	{
+		/* Game is no longer replayed */
+		replaying = 0;
+
+		/* Skip game */
+		return 0;
+	}
+
+	/* Abandon game on errors */
+	replaying = 1;
+
+	/* Skip player notifications */
+	g->fast_forward = 1;
+
+	/* Begin game */
+	begin_game(g);
+
+	/* Clear recorded states */
+	num_state = 0;
+
+	/* Play rounds */
+	do
+	{
+		/* Check for too many rounds */
+		if (num_state == MAX_STATE - 1)
+		{
+			/* Game is no longer replayed */
+			replaying = 0;
+
+			/* Skip game */
+			return 0;
+		}
+
+		/* Record inputs at start of round */
+		record_round(g, eval, role);
+
+		/* Play round */
+		more = game_round(g);
+
+		/* Loop over players */
+		for (i = 0; i < g->num_players; i++)
+		{
+			/* Note role output chosen */
+			role_target[i][num_state - 1] = ai_role_output(g, i);
+		}
+
+	} while (more);
+
+	/* Game is no longer replayed */
+	replaying = 0;
+
+	/* Skip games changed in debug mode */
+	if (g->debug_game) return 0;
+
+	/* Score game */
+	score_game(g);
+
+	/* Declare winner */
+	declare_winner(g);
+
+	/* Record final state */
+	record_round(g, eval, role);
+
+	/* Write records */
+	write_records(g, eval, role, eval_fff, role_fff, num_eval, num_role);
+
+	/* Game used */
+	return 1;
+}
+
+/*
+ * Replay all games in the given files into the buffers.
+ *
+ * Returns the number of games used.
+ */
+static int extract_files(int num_files, char *files[], char *buf_name)
+{
+	game my_game;
+	FILE *eval_fff, *role_fff;
+	char fname[1024];
+	long num_eval = 0, num_role = 0;
+	int i, j, single, num_used = 0, num_skipped = 0;
+
+	/* Create eval buffer */
+	sprintf(fname, "%.1000s.eval", buf_name);
+	eval_fff = fopen(fname, "wb");
+
+	/* Create role buffer */
+	sprintf(fname, "%.1000s.role", buf_name);
+	role_fff = fopen(fname, "wb");
+
+	/* Check for failure */
+	if (!eval_fff || !role_fff)
+	{
+		/* Error */
+		display_error("Could not create training buffer!\n");
+		exit(1);
+	}
+
+	/* Create choice logs */
+	for (i = 0; i < MAX_PLAYER; i++)
+	{
+		/* Create log */
+		my_game.p[i].choice_log = (int *)malloc(sizeof(int) * 4096);
+	}
+
+	/* Loop over files */
+	for (i = 0; i < num_files; i++)
+	{
+		/* Assume file is an archive */
+		single = 0;
+
+		/* Loop over games in file */
+		for (j = 0; ; j++)
+		{
+			/* Assume room for whole pool */
+			random_len = MAX_RAND;
+
+			/* Load game from archive */
+			if (load_archive_game(&my_game, files[i], j,
+			                      random_pool, &random_len) < 0)
+			{
+				/* Stop at end of archive */
+				if (j > 0) break;
+
+				/* No pool */
+				random_len = 0;
+
+				/* Try as save or export file */
+				if (load_game(&my_game, files[i]) < 0)
+				{
+					/* Error */
+					fprintf(stderr, "Could not load %s\n",
+					        files[i]);
+					break;
+				}
+
+				/* Only one game in file */
+				single = 1;
+			}
+
+			/* Play game and count */
+			if (extract_game(&my_game, eval_fff, role_fff,
+			                 &num_eval, &num_role))
+			{
+				/* Count used game */
+				num_used++;
+			}
+			else
+			{
+				/* Count skipped game */
+				num_skipped++;
+			}
+
+			/* Free human name */
+			if (my_game.human_name) free(my_game.human_name);
+
+			/* Stop after single game files */
+			if (single) break;
+		}
+	}
+
+	/* Close buffers */
+	fclose(eval_fff);
+	fclose(role_fff);
+
+	/* Print summary */
+	printf("Extracted %d games (%d skipped): %ld eval and %ld role "
+	       "records\n", num_used, num_skipped, num_eval, num_role);
+
+	/* Return games used */
+	return num_used;
+}
+
+/*
+ * Create an array of rows that share one contiguous block.
+ */
+static double **make_rows(int rows, int cols)
+{
+	double **row;
+	int i;
+
+	/* Create array of rows */
+	row = (double **)malloc(sizeof(double *) * rows);
+
+	/* Create block for all rows */
+	row[0] = (double *)malloc(sizeof(double) * rows * cols);
+
+	/* Point rows into block */
+	for (i = 1; i < rows; i++) row[i] = row[0] + i * cols;
+
+	/* Return rows */
+	return row;
+}
+
+/*
+ * Add a worker's deltas to the main network's and clear them.
+ */
+static void move_deltas(double *dest, double *src, int num)
+{
+	int i;
+
+	/* Loop over deltas */
+	for (i = 0; i < num; i++)
+	{
+		/* Move delta */
+		dest[i] += src[i];
+		src[i] = 0;
+	}
+}
+
+/*
+ * Train a worker's network copy on its share of a batch.
+ */
+static void *train_worker(void *arg)
+{
+	worker *w_ptr = (worker *)arg;
+	net *learn = &w_ptr->learn;
+	int size = record_size(learn);
+	int i, j;
+
+	/* Loop over records */
+	for (i = 0; i < w_ptr->num; i++)
+	{
+		/* Read record */
+		if (pread(w_ptr->fd, w_ptr->record, sizeof(float) * size,
+		          (off_t)w_ptr->list[i] * size * sizeof(float)) !=
+		    sizeof(float) * size)
+		{
+			/* Error */
+			display_error("Could not read training buffer!\n");
+			exit(1);
+		}
+
+		/* Copy inputs */
+		for (j = 0; j < learn->num_inputs + 1; j++)
+		{
+			/* Copy input */
+			w_ptr->input[i][j] = w_ptr->record[j];
+		}
+
+		/* Copy desired outputs */
+		for (j = 0; j < learn->num_output; j++)
+		{
+			/* Copy output */
+			w_ptr->desired[i][j] = w_ptr->record[learn->num_inputs +
+			                                     1 + j];
+		}
+	}
+
+	/* Accumulate training of whole share */
+	train_net_batch(learn, w_ptr->num, w_ptr->input, NULL, w_ptr->desired);
+
+	/* Done */
+	return NULL;
+}
+
+/*
+ * Train a network on a buffer file, and return the number of records.
+ */
+static long train_buffer(net *learn, char *fname)
+{
+	worker workers[MAX_THREAD], *w_ptr;
+	pthread_t thread[MAX_THREAD];
+	struct stat st;
+	int *order;
+	int size = record_size(learn);
+	int fd, e, i, j, k, t, num_records, first, num, share;
+
+	/* Open buffer */
+	fd = open(fname, O_RDONLY);
+
+	/* Check for failure */
+	if (fd < 0 || fstat(fd, &st) < 0)
+	{
+		/* Error */
+		fprintf(stderr, "Could not open %s\n", fname);
+		return 0;
+	}
+
+	/* Count records */
+	num_records = st.st_size / (sizeof(float) * size);
+
+	/* Check for no records */
+	if (!num_records)
+	{
+		/* Close buffer */
+		close(fd);
+		return 0;
+	}
+
+	/* Create record order */
+	order = (int *)malloc(sizeof(int) * num_records);
+
+	/* Start with file order */
+	for (i = 0; i < num_records; i++) order[i] = i;
+
+	/* Most records any worker gets from one batch */
+	share = (batch_size + num_threads - 1) / num_threads;
+
+	/* Loop over workers */
+	for (t = 0; t < num_threads; t++)
+	{
+		/* Get worker pointer */
+		w_ptr = &workers[t];
+
+		/* Create network copy */
+		make_learner(&w_ptr->learn, learn->num_inputs,
+		             learn->num_hidden, learn->num_output);
+
+		/* Use same learning rate */
+		w_ptr->learn.alpha = learn->alpha;
+
+		/* Remember own weights */
+		w_ptr->own_hidden = w_ptr->learn.hidden_weight;
+		w_ptr->own_output = w_ptr->learn.output_weight;
+
+		/* Share weights of main network */
+		w_ptr->learn.hidden_weight = learn->hidden_weight;
+		w_ptr->learn.output_weight = learn->output_weight;
+
+		/* Set buffer and scratch space */
+		w_ptr->fd = fd;
+		w_ptr->record = (float *)malloc(sizeof(float) * size);
+		w_ptr->input = make_rows(share, learn->num_inputs + 1);
+		w_ptr->desired = make_rows(share, learn->num_output);
+		w_ptr->list = (int *)malloc(sizeof(int) * share);
+	}
+
+	/* Loop over epochs */
+	for (e = 0; e < epochs; e++)
+	{
+		/* Shuffle record order */
+		for (i = num_records - 1; i > 0; i--)
+		{
+			/* Pick record to swap with */
+			j = simple_rand(&shuffle_seed) % (i + 1);
+
+			/* Swap */
+			k = order[i];
+			order[i] = order[j];
+			order[j] = k;
+		}
+
+		/* Clear error counters */
+		for (t = 0; t < num_threads; t++)
+		{
+			/* Clear counters */
+			workers[t].learn.error = workers[t].learn.num_error = 0;
+		}
+
+		/* Loop over batches */
+		for (first = 0; first < num_records; first += batch_size)
+		{
+			/* Get batch size */
+			num = num_records - first;
+			if (num > batch_size) num = batch_size;
+
+			/* Deal records to workers */
+			for (t = 0; t < num_threads; t++) workers[t].num = 0;
+			for (i = 0; i < num; i++)
+			{
+				/* Get worker */
+				w_ptr = &workers[i % num_threads];
+
+				/* Add record */
+				w_ptr->list[w_ptr->num++] = order[first + i];
+			}
+
+			/* Start helper threads */
+			for (t = 1; t < num_threads; t++)
+			{
+				/* Start thread */
+				pthread_create(&thread[t], NULL, train_worker,
+				               &workers[t]);
+			}
+
+			/* Train first share ourselves */
+			train_worker(&workers[0]);
+
+			/* Wait for helper threads */
+			for (t = 1; t < num_threads; t++)
+			{
+				/* Wait for thread */
+				pthread_join(thread[t], NULL);
+			}
+
+			/* Loop over workers */
+			for (t = 0; t < num_threads; t++)
+			{
+				/* Get worker pointer */
+				w_ptr = &workers[t];
+
+				/* Collect hidden weight deltas */
+				move_deltas(learn->hidden_delta[0],
+				            w_ptr->learn.hidden_delta[0],
+				            (learn->num_inputs + 1) *
+				             learn->num_hidden);
+
+				/* Collect output weight deltas */
+				move_deltas(learn->output_delta[0],
+				            w_ptr->learn.output_delta[0],
+				            (learn->num_hidden + 1) *
+				             learn->num_output);
+			}
+
+			/* Apply batch */
+			apply_training(learn);
+		}
+
+		/* Sum error of epoch */
+		learn->error = learn->num_error = 0;
+		for (t = 0; t < num_threads; t++)
+		{
+			/* Add worker's error */
+			learn->error += workers[t].learn.error;
+			learn->num_error += workers[t].learn.num_error;
+		}
+
+		/* Print progress */
+		printf("%s epoch %d: error %f\n", fname, e + 1,
+		       learn->error / learn->num_error);
+	}
+
+	/* Loop over workers */
+	for (t = 0; t < num_threads; t++)
+	{
+		/* Get worker pointer */
+		w_ptr = &workers[t];
+
+		/* Restore own weights */
+		w_ptr->learn.hidden_weight = w_ptr->own_hidden;
+		w_ptr->learn.output_weight = w_ptr->own_output;
+
+		/* Free network copy and scratch space */
+		free_net(&w_ptr->learn);
+		free(w_ptr->record);
+		free(w_ptr->input[0]);
+		free(w_ptr->input);
+		free(w_ptr->desired[0]);
+		free(w_ptr->desired);
+		free(w_ptr->list);
+	}
+
+	/* Free order */
+	free(order);
+
+	/* Close buffer */
+	close(fd);
+
+	/* Return number of records */
+	return num_records;
+}
+
+/*
+ * Extract training records from archived games, train and save networks.
+ */
+int main(int argc, char *argv[])
+{
+	game my_game;
+	net *eval, *role;
+	char *buf_name = "trainer.buf", *out_dir = "network";
+	char fname[1024];
+	int i, num_games = 0;
+
+	/* Read card database */
+	if (read_cards(NULL) < 0)
+	{
+		/* Exit */
+		exit(1);
+	}
+
+	/* Read campaign database */
+	read_campaign();
+
+	/* Use all processors by default */
+	num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	/* Parse arguments */
+	for (i = 1; i < argc && argv[i][0] == '-'; i++)
+	{
+		/* Check for verbosity */
+		if (!strcmp(argv[i], "-v"))
+		{
+			/* Set verbose flag */
+			verbose++;
+		}
+
+		/* Check for number of players */
+		else if (!strcmp(argv[i], "-p"))
+		{
+			/* Set number of players */
+			num_players = atoi(argv[++i]);
+		}
+
+		/* Check for advanced game */
+		else if (!strcmp(argv[i], "-a"))
+		{
+			/* Set advanced flag */
+			advanced = 1;
+		}
+
+		/* Check for expansion level */
+		else if (!strcmp(argv[i], "-e"))
+		{
+			/* Set expansion level */
+			expanded = atoi(argv[++i]);
+		}
+
+		/* Check for learning rate factor */
+		else if (!strcmp(argv[i], "-f"))
+		{
+			/* Set factor */
+			factor = atof(argv[++i]);
+		}
+
+		/* Check for lambda */
+		else if (!strcmp(argv[i], "-l"))
+		{
+			/* Set lambda (1 trains on final outcomes only) */
+			lambda = atof(argv[++i]);
+		}
+
+		/* Check for number of epochs */
+		else if (!strcmp(argv[i], "-n"))
+		{
+			/* Set number of passes over buffer */
+			epochs = atoi(argv[++i]);
+		}
+
+		/* Check for batch size */
+		else if (!strcmp(argv[i], "-B"))
+		{
+			/* Set minibatch size */
+			batch_size = atoi(argv[++i]);
+		}
+
+		/* Check for number of threads */
+		else if (!strcmp(argv[i], "-t"))
+		{
+			/* Set number of training threads */
+			num_threads = atoi(argv[++i]);
+		}
+
+		/* Check for shuffle seed */
+		else if (!strcmp(argv[i], "-s"))
+		{
+			/* Set seed */
+			shuffle_seed = atoi(argv[++i]);
+		}
+
+		/* Check for buffer name */
+		else if (!strcmp(argv[i], "-b"))
+		{
+			/* Set buffer file prefix */
+			buf_name = argv[++i];
+		}
+
+		/* Check for output directory */
+		else if (!strcmp(argv[i], "-o"))
+		{
+			/* Set directory for network files */
+			out_dir = argv[++i];
+		}
+
+		/* Unknown option */
+		else
+		{
+			/* Print usage */
+			fprintf(stderr, "Usage: trainer [-e exp] [-p players] "
+			        "[-a] [-f factor] [-l lambda] [-n epochs] "
+			        "[-B batch] [-t threads] [-s seed] "
+			        "[-b buffer] [-o dir] [-v] [game files...]\n");
+			exit(1);
+		}
+	}
+
+	/* Clamp number of threads */
+	if (num_threads < 1) num_threads = 1;
+	if (num_threads > MAX_THREAD) num_threads = MAX_THREAD;
+
+	/* Clamp batch size */
+	if (batch_size < 1) batch_size = 1;
+
+	/* Check for game files */
+	if (i < argc)
+	{
+		/* Replay games into buffer */
+		num_games = extract_files(argc - i, argv + i, buf_name);
+	}
+
+	/* Set up empty game with trained configuration */
+	my_game.num_players = num_players;
+	my_game.expanded = expanded;
+	my_game.advanced = advanced;
+	my_game.promo = 0;
+	my_game.goal_disabled = 0;
+	my_game.takeover_disabled = 0;
+	my_game.camp = NULL;
+	my_game.start_seed = 1;
+	random_len = 0;
+
+	/* Create empty choice logs */
+	for (i = 0; i < num_players; i++)
+	{
+		/* Create log */
+		my_game.p[i].choice_log = (int *)malloc(sizeof(int) * 4096);
+		my_game.p[i].choice_size = 0;
+	}
+
+	/* Initialize game and AI */
+	setup_game(&my_game);
+
+	/* Get networks */
+	eval = ai_eval_inputs(&my_game, 0);
+	role = ai_role_inputs(&my_game, 0);
+
+	/* Train eval network */
+	sprintf(fname, "%.1000s.eval", buf_name);
+	if (train_buffer(eval, fname))
+	{
+		/* Count games trained */
+		eval->num_training += num_games;
+
+		/* Save weights */
+		sprintf(fname, "%.900s/rftg.eval.%d.%d%s.net", out_dir,
+		        expanded, num_players, advanced ? "a" : "");
+		save_net(eval, fname);
+	}
+
+	/* Train role network */
+	sprintf(fname, "%.1000s.role", buf_name);
+	if (train_buffer(role, fname))
+	{
+		/* Count games trained */
+		role->num_training += num_games;
+
+		/* Save weights */
+		sprintf(fname, "%.900s/rftg.role.%d.%d%s.net", out_dir,
+		        expanded, num_players, advanced ? "a" : "");
+		save_net(role, fname);
+	}
+
+	/* Done */
+	return 0;
+}
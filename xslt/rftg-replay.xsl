@@ -32,6 +32,52 @@
     </html>
   </xsl:template>
 
+  <xsl:template match="/RftgReplay">
+    <html>
+      <head>
+        <style type="text/css">
+        body { font-family: Lucida, sans-serif; }
+        .em { font-weight:bold }
+        .phase { color:#0000aa }
+        .takeover { color:#ff0000 }
+        .goal { color:#eeaa00 }
+        .prestige { color:#8800bb }
+        .verbose { color:#aaaaaa }
+        .discard { color:#aaaaaa }
+        .draw { color:#aaaaaa }
+        .chat { font-weight:bold }
+        .debug { background-color:#ff5555 }
+        .highlight { background-color:yellow }
+        .decision { display:none }
+        .decision:target { display:block }
+        </style>
+      </head>
+      <body>
+        <xsl:apply-templates select="Links" />
+        <xsl:apply-templates select="Decision" />
+      </body>
+    </html>
+  </xsl:template>
+
+  <!-- A decision only holds the status and players that changed since the
+       same player's previous decision; the rest refer back to it. -->
+  <xsl:template match="Decision">
+    <xsl:variable name="who" select="@player" />
+    <xsl:variable name="seen" select="preceding-sibling::Decision[@player = $who] | ." />
+    <xsl:variable name="status" select="($seen/Status[not(@same)])[last()]" />
+    <div class="decision" id="{@id}">
+      <xsl:apply-templates select="Links" />
+      <xsl:apply-templates select="$status" mode="statusHeader" />
+      <xsl:for-each select="Player">
+        <xsl:variable name="id" select="@id" />
+        <xsl:apply-templates select="($seen/Player[@id = $id][not(@same)])[last()]" />
+      </xsl:for-each>
+      <xsl:apply-templates select="Log" />
+      <xsl:apply-templates select="$status/Message" mode="statusFooter" />
+      <xsl:apply-templates select="Links[@text='Navigate']" />
+    </div>
+  </xsl:template>
+
   <xsl:template match="Link">
     <a href="{.}"><xsl:value-of select="@text" /></a><xsl:if test="position() != last()"> - </xsl:if>
   </xsl:template>
@@ -114,7 +160,7 @@
   </xsl:template>
 
   <xsl:template match="Actions" mode="player">
-    Action<xsl:if test="/RftgExport/Setup/Players/@advanced = 'yes'">s</xsl:if>:
+    Action<xsl:if test="/*/Setup/Players/@advanced = 'yes'">s</xsl:if>:
     <xsl:apply-templates select="Action" />
     <br />
   </xsl:template>